@@ -1,21 +1,53 @@
+// Windows: só o núcleo da API do sistema (mapeamento de arquivos, pilha de
+// chamadas do AllocTracker), sem as macros min/max que atropelam std::min/std::max
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#endif
 #include <SFML/Graphics.hpp>
 #include <SFML/Audio.hpp>
+#include <SFML/Network.hpp>
 #include <iostream>
 #include <vector>
 #include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <new>
 #include <ctime>
 #include <string>
 #include <sstream>
+#include <fstream>
 #include <map>
+#include <unordered_set>
 #include <algorithm>
 #include <cmath>
 #include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <random>
+#include <queue>
+#include <deque>
+#include <memory>
+#include <memory_resource>
+#include <coroutine>
+#include <utility>
+#include <limits>
 #include <iomanip>
+#include <csignal>
 
 #define MOBILE_RESOLUTION_X 720
 #define MOBILE_RESOLUTION_Y 1280
 #define TOUCH_THRESHOLD 10.0f
 
+#define SIM_TICK_RATE 60
+#define SIM_DT (1.0f / SIM_TICK_RATE)
+#define WASTE_SCALE 0.18f
+#define BIN_SCALE 0.25f
+#define BIN_WIDTH 100.0f
+#define MAGNET_SPEED 8.0f
+
 using namespace sf;
 using namespace std;
 
@@ -39,694 +71,1417 @@ enum GamePhase {
     BOSS // Nova fase
 };
 
-// --- Waste ---
-class Waste {
-public:
-    WasteType type;
-    Sprite sprite;
-    Vector2f velocity;
-    bool active;
-    Color originalColor;
-
-    Waste(Texture& texture, WasteType t, int phase = 0) : type(t), active(true) {
-        sprite.setTexture(texture);
-        sprite.setScale(0.18f, 0.18f); // Aumentado para mobile
-        sprite.setPosition(rand() % (MOBILE_RESOLUTION_X - 100), -50);
-        // Velocidade ajustada: base 1.5 + 0.4 * fase + aleatório
-        velocity = Vector2f(0, 1.5f + phase * 0.4f + (rand() % 10) * 0.08f);
-        sprite.setColor(Color::White);
-        originalColor = Color::White;
-    }
-
-    // Retorna true se passou do limite
-    bool update(float speedFactor = 1.0f) {
-        sprite.move(velocity * speedFactor);
-        if (sprite.getPosition().y > MOBILE_RESOLUTION_Y - 200) {
-            active = false;
-            return true;
-        }
-        return false;
-    }
+// Arquivos de textura na ordem de WasteType
+const char* const WASTE_TEXTURE_FILES[NONE] = {
+    "assets/textures/paper.png",
+    "assets/textures/plastic.png",
+    "assets/textures/metal.png",
+    "assets/textures/glass.png",
+    "assets/textures/organic.png",
+    "assets/textures/electronic.png",
+    "assets/textures/battery.png"
 };
 
-class PowerUp {
-public:
-    enum Type {
-        COMBO_BOOST,
-        TIME_FREEZE,
-        MAGNET,
-        SHIELD,
-        BOSS_DAMAGE // Novo power-up para atacar o boss
-    };
+const char* const BIN_TEXTURE_FILES[NONE] = {
+    "assets/textures/paperbin.png",
+    "assets/textures/plasticbin.png",
+    "assets/textures/metalbin.png",
+    "assets/textures/glassbin.png",
+    "assets/textures/organicbin.png",
+    "assets/textures/electronicbin.png",
+    "assets/textures/batterybin.png"
+};
 
-    Type type;
-    Sprite sprite;
-    CircleShape glowEffect; // Efeito de brilho ao redor
-    bool active;
-    float lifetime; // Tempo de vida restante
+// --- Balanceamento ---
+// Todas as constantes de dificuldade num só lugar, para que o modo
+// de simulação em lote consiga variar cada uma delas.
+struct BalanceParams {
+    // Velocidade dos resíduos: base + fase * incremento + (0..9) * variação
+    float wasteBaseSpeed = 1.5f;
+    float wasteSpeedPerPhase = 0.4f;
+    float wasteSpeedJitter = 0.08f;
+
+    // Spawn de resíduos: intervalo = base - fase * redução, limite = base + fase * incremento
+    float spawnIntervalBase = 2.0f;
+    float spawnIntervalPerPhase = 0.2f;
+    int maxWastesBase = 5;
+    int maxWastesPerPhase = 2;
+
+    // Spawn de power-ups: sorteio a cada período com chance (%) por fase
+    float powerUpSpawnPeriod = 3.0f;
+    int powerUpChanceCommunity = 30;
+    int powerUpChanceIndustrial = 50;
+    int powerUpChanceMegacenter = 60;
+
+    // Pontuação e reputação
+    int basePoints = 5;
+    int magnetPoints = 5;
+    float comboTimeout = 5.0f;
+    int reputationGain = 2;
+    int reputationWrongPenalty = 10;
+    int reputationMissPenalty = 7;
+
+    // Fase do boss
+    int playerLifeGain = 5;
+    int playerLifeWrongPenalty = 10;
+    int playerLifeMissPenalty = 10;
+    int bossDamage = 25;
+    int hitsPerBossPowerUp = 5;
+
+    // Ataques do boss (Simulation::bossScript)
+    float bossBurstPeriod = 15.0f;  // Segundos entre rajadas de baterias
+    int bossBurstSize = 2;          // Ondas por rajada
+    float bossBurstDuration = 2.0f; // Segundos para soltar uma rajada inteira
+    int bossWaveSize = 3;           // Resíduos lado a lado em cada onda
+    float bossWaveAmplitude = 120.0f; // Desvio lateral das curvas das ondas, em pixels
+    int bossRageLife = 50;          // Abaixo desta vida o boss troca de padrão
+    float bossRainPeriod = 4.0f;    // Segundos entre resíduos da chuva tóxica
+
+    // Pontuação necessária para concluir cada fase
+    int scoreToIndustrial = 60;
+    int scoreToMegacenter = 120;
+    int scoreToBoss = 240;
+};
 
-    PowerUp(Texture& texture, Type t) : type(t), active(true), lifetime(10.0f) {
-        sprite.setTexture(texture);
-        sprite.setScale(0.12f, 0.12f); // Aumentado para mobile
-        sprite.setPosition(rand() % (MOBILE_RESOLUTION_X - 100), -50);
+// Altera um parâmetro pelo nome (usado pela linha de comando)
+bool setBalanceParam(BalanceParams& params, const string& name, float value) {
+    static const map<string, float BalanceParams::*> floatParams = {
+        {"wasteBaseSpeed", &BalanceParams::wasteBaseSpeed},
+        {"wasteSpeedPerPhase", &BalanceParams::wasteSpeedPerPhase},
+        {"wasteSpeedJitter", &BalanceParams::wasteSpeedJitter},
+        {"spawnIntervalBase", &BalanceParams::spawnIntervalBase},
+        {"spawnIntervalPerPhase", &BalanceParams::spawnIntervalPerPhase},
+        {"powerUpSpawnPeriod", &BalanceParams::powerUpSpawnPeriod},
+        {"comboTimeout", &BalanceParams::comboTimeout},
+        {"bossBurstPeriod", &BalanceParams::bossBurstPeriod},
+        {"bossBurstDuration", &BalanceParams::bossBurstDuration},
+        {"bossWaveAmplitude", &BalanceParams::bossWaveAmplitude},
+        {"bossRainPeriod", &BalanceParams::bossRainPeriod}
+    };
+    static const map<string, int BalanceParams::*> intParams = {
+        {"maxWastesBase", &BalanceParams::maxWastesBase},
+        {"maxWastesPerPhase", &BalanceParams::maxWastesPerPhase},
+        {"powerUpChanceCommunity", &BalanceParams::powerUpChanceCommunity},
+        {"powerUpChanceIndustrial", &BalanceParams::powerUpChanceIndustrial},
+        {"powerUpChanceMegacenter", &BalanceParams::powerUpChanceMegacenter},
+        {"basePoints", &BalanceParams::basePoints},
+        {"magnetPoints", &BalanceParams::magnetPoints},
+        {"reputationGain", &BalanceParams::reputationGain},
+        {"reputationWrongPenalty", &BalanceParams::reputationWrongPenalty},
+        {"reputationMissPenalty", &BalanceParams::reputationMissPenalty},
+        {"playerLifeGain", &BalanceParams::playerLifeGain},
+        {"playerLifeWrongPenalty", &BalanceParams::playerLifeWrongPenalty},
+        {"playerLifeMissPenalty", &BalanceParams::playerLifeMissPenalty},
+        {"bossDamage", &BalanceParams::bossDamage},
+        {"hitsPerBossPowerUp", &BalanceParams::hitsPerBossPowerUp},
+        {"bossBurstSize", &BalanceParams::bossBurstSize},
+        {"bossWaveSize", &BalanceParams::bossWaveSize},
+        {"bossRageLife", &BalanceParams::bossRageLife},
+        {"scoreToIndustrial", &BalanceParams::scoreToIndustrial},
+        {"scoreToMegacenter", &BalanceParams::scoreToMegacenter},
+        {"scoreToBoss", &BalanceParams::scoreToBoss}
+    };
 
-        // Configurar o efeito de brilho (aumentado para touch)
-        glowEffect.setRadius(48.0f);
-        glowEffect.setFillColor(Color(255, 255, 255, 100)); // Semi-transparente
-        glowEffect.setOrigin(48.0f, 48.0f); // Centraliza o brilho
-        glowEffect.setPosition(sprite.getPosition().x + 35, sprite.getPosition().y + 35);
+    auto f = floatParams.find(name);
+    if (f != floatParams.end()) {
+        params.*(f->second) = value;
+        return true;
+    }
+    auto i = intParams.find(name);
+    if (i != intParams.end()) {
+        params.*(i->second) = static_cast<int>(lround(value));
+        return true;
+    }
+    return false;
+}
+
+// --- Configuração por fase ---
+// Tudo o que muda de uma fase para outra, resolvido em tempo de compilação.
+// Valores ajustáveis no balanceamento apontam para campos de BalanceParams.
+struct PhaseConfig {
+    const char* label;
+    const char* background;
+    WasteType bins[NONE];
+    int binCount;
+    float binY;                         // Topo das lixeiras
+    int wasteTypeCount;                 // Resíduos sorteados entre os N primeiros tipos
+    int difficulty;                     // Quantas vezes aplicar os incrementos "PerPhase"
+    int BalanceParams::* powerUpChance;
+    int BalanceParams::* scoreTarget;   // nullptr: a fase termina ao derrotar o boss
+    bool specialEvents;                 // Greves, chuvas e falhas do megacentro
+};
 
-        // Centralizar o sprite no glowEffect
-        FloatRect spriteBounds = sprite.getLocalBounds();
-        sprite.setOrigin(spriteBounds.width / 2, spriteBounds.height / 2);
-        sprite.setPosition(glowEffect.getPosition());
+constexpr PhaseConfig PHASE_CONFIGS[BOSS + 1] = {
+    {
+        "Centro Comunitario", "assets/textures/bg_community.png",
+        {PAPER, PLASTIC, METAL}, 3,
+        MOBILE_RESOLUTION_Y - 250.0f, 3, 0,
+        &BalanceParams::powerUpChanceCommunity, &BalanceParams::scoreToIndustrial, false
+    },
+    {
+        "Expansao Industrial", "assets/textures/bg_industrial.png",
+        {PAPER, PLASTIC, METAL, GLASS, ORGANIC}, 5,
+        MOBILE_RESOLUTION_Y - 250.0f, 5, 1,
+        &BalanceParams::powerUpChanceIndustrial, &BalanceParams::scoreToMegacenter, false
+    },
+    {
+        "Megacentro Urbano", "assets/textures/bg_megacenter.png",
+        {PAPER, PLASTIC, METAL, GLASS, ORGANIC, ELECTRONIC, BATTERY}, 7,
+        MOBILE_RESOLUTION_Y - 250.0f, 7, 2,
+        &BalanceParams::powerUpChanceMegacenter, &BalanceParams::scoreToBoss, true
+    },
+    {
+        // Boss usa todas as lixeiras, um pouco mais altas
+        "BOSS FINAL", "assets/textures/bg_boss.png",
+        {PAPER, PLASTIC, METAL, GLASS, ORGANIC, ELECTRONIC, BATTERY}, 7,
+        MOBILE_RESOLUTION_Y - 300.0f, 7, 3,
+        &BalanceParams::powerUpChanceMegacenter, nullptr, false
     }
+};
 
-    // Atualiza a posição e o efeito de piscar
-    bool update(float deltaTime) {
-        sprite.move(0, 2.0f); // Velocidade fixa
-        glowEffect.move(0, 2.0f);
+// Tamanho em pixels das texturas, usado nas áreas de toque.
+// O Game preenche a partir das texturas carregadas; o modo em lote
+// lê só o cabeçalho das imagens, sem precisar de contexto OpenGL.
+struct SpriteMetrics {
+    Vector2f wasteSize[NONE];
+    Vector2f binSize[NONE];
+
+    SpriteMetrics() {
+        // Mesmos tamanhos das texturas de fallback
+        for (int i = 0; i < NONE; i++) {
+            wasteSize[i] = Vector2f(50, 50);
+            binSize[i] = Vector2f(70, 100);
+        }
+    }
 
-        // Piscar (alternar transparência)
-        int alpha = static_cast<int>(sin(lifetime * 5) * 50 + 150);
-        glowEffect.setFillColor(Color(255, 255, 255, alpha));
+    static SpriteMetrics loadFromImages() {
+        SpriteMetrics metrics;
+        for (int i = 0; i < NONE; i++) {
+            imageSize(WASTE_TEXTURE_FILES[i], metrics.wasteSize[i]);
+            imageSize(BIN_TEXTURE_FILES[i], metrics.binSize[i]);
+        }
+        return metrics;
+    }
 
-        lifetime -= deltaTime;
-        if (lifetime <= 0 || sprite.getPosition().y > MOBILE_RESOLUTION_Y - 200) {
-            active = false;
-            return true; // Indica que o power-up deve ser removido
+    // PNG: largura e altura do bloco IHDR; outros formatos decodificam a imagem
+    static bool imageSize(const char* file, Vector2f& size) {
+        ifstream in(file, ios::binary);
+        unsigned char header[24];
+        if (in.read(reinterpret_cast<char*>(header), sizeof(header)) &&
+            memcmp(header + 1, "PNG", 3) == 0 && memcmp(header + 12, "IHDR", 4) == 0) {
+            size.x = static_cast<float>(header[16] << 24 | header[17] << 16 | header[18] << 8 | header[19]);
+            size.y = static_cast<float>(header[20] << 24 | header[21] << 16 | header[22] << 8 | header[23]);
+            return true;
+        }
+        Image image;
+        if (image.loadFromFile(file)) {
+            size = Vector2f(image.getSize());
+            return true;
         }
         return false;
     }
 };
 
-class Game {
-private:
-    RenderWindow window;
-    Vector2f touchStartPosition;
-    vector<Texture> wasteTextures;
-    vector<Waste> activeWastes;
-    vector<Sprite> bins;
-    vector<Text> binLabels;
-    map<WasteType, FloatRect> binBounds;
-    map<WasteType, Texture> binTextures; 
+// --- TimerWheel ---
+// Roda de temporizadores hierárquica contada em ticks de simulação.
+// 4 níveis de 64 posições cobrem 2^24 ticks (~77 h a 60 Hz). Um tick custa
+// O(temporizadores que vencem + os que descem de nível), não O(todos).
+// Como só anda quando a simulação anda, todos os timers pausam juntos.
+class TimerWheel {
+public:
+    // generation 0 nunca é usada, então um Handle padrão é sempre inválido
+    struct Handle {
+        unsigned index = 0;
+        unsigned generation = 0;
+    };
 
-    Font font;
-    Text scoreText;
-    Text phaseText;
-    Text messageText;
-    Text reputationText;
-    Text comboText;
-    Text comboMultiplierText;
+    TimerWheel() {
+        clear();
+    }
 
-    RectangleShape reputationBar;
-    RectangleShape reputationBarBack;
+    void clear() {
+        nodes.clear();
+        freeList = NIL;
+        currentTick = 0;
+        for (auto& level : slots) {
+            fill(begin(level), end(level), NIL);
+        }
+    }
 
-    int score;
-    int reputation;
-    int phase;
-    int combo;
-    float spawnTimer;
-    float gameTimer;
-    float eventTimer;
-    bool specialEvent;
-    string currentEvent;
-
-    SoundBuffer correctBuffer;
-    SoundBuffer wrongBuffer;
-    SoundBuffer selectBuffer; // Novo buffer para seleção
-    Sound sound;
+    Uint64 now() const {
+        return currentTick;
+    }
 
-    Clock comboClock;
-    Clock powerUpClock;
+    // Memória ocupada pela roda (o pool de nós cresce conforme o uso)
+    size_t memoryBytes() const {
+        return sizeof(*this) + nodes.capacity() * sizeof(Node);
+    }
 
-    // Troque Waste* selectedWaste por:
-    int selectedWasteIndex = -1;
+    static Uint64 ticksFor(float seconds) {
+        return static_cast<Uint64>(max(1L, lround(seconds * SIM_TICK_RATE)));
+    }
 
-    // Novas variáveis para a tela inicial
-    bool inStartScreen = true;
-    RectangleShape startButton;
-    Text startButtonText;
-    Text gameTitle;
-    Music bgMusic;
+    // Agenda kind/payload para daqui a delayTicks (mínimo 1)
+    Handle schedule(Uint64 delayTicks, int kind, unsigned payload = 0) {
+        unsigned index = allocate();
+        Node& node = nodes[index];
+        node.expiry = currentTick + max<Uint64>(1, delayTicks);
+        node.kind = kind;
+        node.payload = payload;
+        insert(index);
+        return Handle{index, node.generation};
+    }
 
-    // Variáveis para controle de som
-    Texture soundOnTex, soundOffTex;
-    Sprite soundIcon;
-    bool soundMuted = false;
-    RectangleShape volumeBar;
-    RectangleShape volumeFill;
-    bool volumeDragging = false;
+    bool pending(Handle handle) const {
+        return handle.generation != 0 && handle.index < nodes.size() &&
+               nodes[handle.index].generation == handle.generation && nodes[handle.index].linked;
+    }
 
-    // --- Adicione estas variáveis na sua classe Game ---
-    Texture bgCommunity, bgIndustrial, bgMegacenter, bgBoss;
-    Texture playerPortraitTex, bossPortraitTex; // Texturas para retratos
-    Sprite bgSprite;
-    Sprite playerPortrait, bossPortrait; // Sprites para retratos
-    bool inLevelTransition = false;
-    bool inIntroStory = true; // Nova tela de introdução
-    bool clickedToTransition = false;
-    bool inBossIntro = false; // Introdução para o boss
-    RectangleShape continueButton;
-    Text continueButtonText;
-    Text levelInfoText;
-    Text storyText; // Texto para a história
-    RectangleShape storyPanel; // Painel para fundo da história
+    Uint64 remaining(Handle handle) const {
+        return pending(handle) ? nodes[handle.index].expiry - currentTick : 0;
+    }
 
-    SoundBuffer victoryBuffer, defeatBuffer;
-    Sound victorySound, defeatSound;
-    bool inDefeatScreen = false;
+    bool cancel(Handle& handle) {
+        if (!pending(handle)) return false;
+        unlink(handle.index);
+        release(handle.index);
+        handle = Handle();
+        return true;
+    }
 
-    vector<PowerUp> activePowerUps; // Power-ups ativos na tela
-    vector<PowerUp::Type> inventory; // Inventário do jogador (máximo de 2)
-    SoundBuffer powerUpBuffer; // Som ao coletar power-up
-    Sound powerUpSound;
+    // Avança um tick e chama onExpire(kind, payload) para cada timer vencido.
+    // O callback pode agendar novos timers.
+    template <class F>
+    void advance(F&& onExpire) {
+        currentTick++;
+
+        // Desce de nível os timers cujo bloco começa agora
+        for (int level = 1; level < LEVELS; level++) {
+            if ((currentTick & ((Uint64(1) << (level * SLOT_BITS)) - 1)) != 0) break;
+            unsigned slot = (currentTick >> (level * SLOT_BITS)) & SLOT_MASK;
+            unsigned index = slots[level][slot];
+            slots[level][slot] = NIL;
+            while (index != NIL) {
+                unsigned next = nodes[index].next;
+                nodes[index].linked = false;
+                insert(index);
+                index = next;
+            }
+        }
 
-    vector<Texture> powerUpTextures; // Texturas exclusivas para power-ups
-    float powerUpSpawnTimer; // Timer para spawn de power-ups
+        // Um de cada vez, para que o callback possa cancelar outro timer da mesma posição
+        unsigned slot = currentTick & SLOT_MASK;
+        while (slots[0][slot] != NIL) {
+            unsigned index = slots[0][slot];
+            unlink(index);
+            int kind = nodes[index].kind;
+            unsigned payload = nodes[index].payload;
+            release(index);
+            onExpire(kind, payload);
+        }
+    }
 
-    // Efeitos de power-up ativos
-    float timeFreezeFactor;
-    float timeFreezeDuration;
-    int shieldCount;
-    float comboBoostMultiplier;
-    float comboBoostDuration;
-    bool magnetActive;
-    float magnetDuration;
+private:
+    static constexpr int LEVELS = 4;
+    static constexpr int SLOT_BITS = 6;
+    static constexpr unsigned SLOT_COUNT = 1u << SLOT_BITS;
+    static constexpr unsigned SLOT_MASK = SLOT_COUNT - 1;
+    static constexpr unsigned NIL = 0xFFFFFFFFu;
+
+    struct Node {
+        Uint64 expiry = 0;
+        int kind = 0;
+        unsigned payload = 0;
+        unsigned generation = 0;
+        unsigned prev = NIL;
+        unsigned next = NIL;
+        int level = 0;
+        unsigned slot = 0;
+        bool linked = false;
+    };
 
-    // Visualização de power-ups ativos
-    vector<Sprite> activePowerUpIcons;
-    vector<RectangleShape> activePowerUpTimers;
-    vector<Text> activePowerUpCounts;
+    vector<Node> nodes; // Pool reaproveitado pela freeList
+    unsigned freeList;
+    Uint64 currentTick;
+    unsigned slots[LEVELS][SLOT_COUNT];
 
-    // Novas variáveis para o texto de feedback de power-ups
-    float powerUpTextTimer = 0.0f;
-    float powerUpTextAlpha = 255.0f;
-    float powerUpTextY = MOBILE_RESOLUTION_Y / 2;
+    unsigned allocate() {
+        unsigned index;
+        if (freeList != NIL) {
+            index = freeList;
+            freeList = nodes[index].next;
+        } else {
+            index = static_cast<unsigned>(nodes.size());
+            nodes.push_back(Node());
+        }
+        nodes[index].generation++;
+        if (nodes[index].generation == 0) nodes[index].generation = 1;
+        return index;
+    }
 
-    // --- Novas variáveis para a fase do boss ---
-    bool inBossFight = false;
-    int playerLife = 100;
-    int bossLife = 100;
-    RectangleShape playerLifeBar;
-    RectangleShape bossLifeBar;
-    RectangleShape playerLifeBarBack; // Fundo da barra de vida do jogador
-    RectangleShape bossLifeBarBack;    // Fundo da barra de vida do boss
-    int correctHitsSinceLastBossPowerUp = 0;
+    void release(unsigned index) {
+        nodes[index].next = freeList;
+        freeList = index;
+    }
 
-public:
-    // --- No construtor ---
-    Game() : window(VideoMode(MOBILE_RESOLUTION_X, MOBILE_RESOLUTION_Y), "Gerenciador de Reciclagem"), 
-              score(0), reputation(100), phase(0), combo(0), spawnTimer(0), 
-              gameTimer(0), eventTimer(0), specialEvent(false), selectedWasteIndex(-1), 
-              inStartScreen(true), powerUpSpawnTimer(0), timeFreezeFactor(1.0f),
-              timeFreezeDuration(0.0f), shieldCount(0), comboBoostMultiplier(1.0f),
-              comboBoostDuration(0.0f), magnetActive(false), magnetDuration(0.0f),
-              inBossFight(false), playerLife(100), bossLife(100), correctHitsSinceLastBossPowerUp(0) {
-        window.setFramerateLimit(60);
-        srand(time(0));
+    // Nível escolhido pela distância até o vencimento; posição pelos bits do vencimento
+    void insert(unsigned index) {
+        Node& node = nodes[index];
+        Uint64 delta = node.expiry > currentTick ? node.expiry - currentTick : 0;
+        int level = 0;
+        while (level < LEVELS - 1 && delta >= (Uint64(1) << ((level + 1) * SLOT_BITS))) {
+            level++;
+        }
+        node.level = level;
+        node.slot = (node.expiry >> (level * SLOT_BITS)) & SLOT_MASK;
+        node.prev = NIL;
+        node.next = slots[level][node.slot];
+        if (node.next != NIL) nodes[node.next].prev = index;
+        slots[level][node.slot] = index;
+        node.linked = true;
+    }
 
-        // Carregar fontes
-        if (!font.loadFromFile("arial.ttf")) {
-            cerr << "Erro ao carregar fonte" << endl;
-            if (!font.loadFromFile("C:/Windows/Fonts/arial.ttf")) {
-                // Se ainda falhar, cria fonte básica
+    void unlink(unsigned index) {
+        Node& node = nodes[index];
+        if (node.prev != NIL) nodes[node.prev].next = node.next;
+        else slots[node.level][node.slot] = node.next;
+        if (node.next != NIL) nodes[node.next].prev = node.prev;
+        node.linked = false;
+    }
+};
+
+// --- Roteiros ---
+// Sequências escritas em linha reta como corrotinas, por exemplo: "mostra o
+// painel, espera o toque, solta 20 baterias em 2 s, espera a vida do boss
+// cair abaixo de 50, troca o padrão". Um roteiro suspenso não custa nada
+// por tick. Uma espera de tempo é um timer numa TimerWheel própria. Uma
+// espera de condição só volta a ser testada quando o sinal dela dispara.
+class Script {
+public:
+    struct promise_type {
+        unsigned slot = 0;               // Roteiro de topo a que este pertence
+        coroutine_handle<> continuation; // Quem chamou este sub-roteiro
+
+        // Ao terminar, um sub-roteiro devolve a vez a quem o chamou
+        struct FinalAwaiter {
+            bool await_ready() noexcept { return false; }
+            coroutine_handle<> await_suspend(coroutine_handle<promise_type> self) noexcept {
+                coroutine_handle<> next = self.promise().continuation;
+                return next ? next : noop_coroutine();
             }
+            void await_resume() noexcept {}
+        };
+
+        Script get_return_object() {
+            return Script(coroutine_handle<promise_type>::from_promise(*this));
         }
+        suspend_always initial_suspend() noexcept { return {}; }
+        FinalAwaiter final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { terminate(); }
+    };
+    typedef coroutine_handle<promise_type> Handle;
 
-        // Configurar textos
-        setupTexts();
+    explicit Script(Handle h) : handle(h) {}
+    Script(Script&& other) noexcept : handle(exchange(other.handle, nullptr)) {}
+    Script(const Script&) = delete;
+    Script& operator=(const Script&) = delete;
 
-        // Carregar texturas
-        loadTextures();
+    ~Script() {
+        if (handle) handle.destroy();
+    }
 
-        // Carregar texturas das lixeiras UMA VEZ
-        loadBinTextures();
+    // co_await sub-roteiro: roda dentro do roteiro atual e volta quando acaba
+    auto operator co_await() && noexcept {
+        struct Awaiter {
+            Handle child;
+            bool await_ready() noexcept { return false; }
+            Handle await_suspend(Handle parent) noexcept {
+                child.promise().slot = parent.promise().slot;
+                child.promise().continuation = parent;
+                return child;
+            }
+            void await_resume() noexcept {}
+        };
+        return Awaiter{handle};
+    }
 
-        // Carregar texturas dos power-ups
-        loadPowerUpTextures();
+    Handle release() {
+        return exchange(handle, nullptr);
+    }
 
-        // Configurar lixeiras
-        setupBins();
+private:
+    Handle handle;
+};
 
-        // Configurar barra de reputação
-        reputationBarBack.setSize(Vector2f(MOBILE_RESOLUTION_X * 0.3f, 25));
-        reputationBarBack.setFillColor(Color(50, 50, 50));
-        reputationBarBack.setPosition(MOBILE_RESOLUTION_X * 0.65f, 80);
-        
-        reputationBar.setSize(Vector2f(MOBILE_RESOLUTION_X * 0.3f, 25));
-        reputationBar.setFillColor(Color(0, 200, 0));
-        reputationBar.setPosition(MOBILE_RESOLUTION_X * 0.65f, 80);
+class ScriptRunner {
+public:
+    // generation 0 nunca é usada, então um Id padrão é sempre inválido
+    struct Id {
+        unsigned index = 0;
+        unsigned generation = 0;
+    };
 
-        // Carregar sons
-        if (!correctBuffer.loadFromFile("assets/sounds/correct.wav")) {
-            cerr << "Erro ao carregar correct.wav" << endl;
-        }
-        if (!wrongBuffer.loadFromFile("assets/sounds/wrong.wav")) {
-            cerr << "Erro ao carregar wrong.wav" << endl;
-        }
-        if (!selectBuffer.loadFromFile("assets/sounds/select.wav")) {
-            cerr << "Erro ao carregar select.wav" << endl;
-        }
+    ScriptRunner() = default;
 
-        // Configurar música de fundo
-        if (!bgMusic.openFromFile("assets/sounds/menu.mp3")) {
-            cerr << "Erro ao carregar musica de fundo" << endl;
+    // Corrotinas não se copiam (e apontam para a Simulation dona)
+    ScriptRunner(const ScriptRunner&) = delete;
+    ScriptRunner& operator=(const ScriptRunner&) = delete;
+
+    ~ScriptRunner() {
+        clear();
+    }
+
+    // Roda já, até a primeira espera. Um roteiro não pode parar a si mesmo.
+    Id start(Script script) {
+        unsigned index;
+        if (!freeSlots.empty()) {
+            index = freeSlots.back();
+            freeSlots.pop_back();
         } else {
-            bgMusic.setLoop(true);
-            bgMusic.play();
-            bgMusic.setVolume(70); // Volume padrão
+            index = static_cast<unsigned>(slots.size());
+            slots.push_back(Slot());
         }
+        Slot& slot = slots[index];
+        slot.top = script.release();
+        slot.top.promise().slot = index;
+        slot.waiting = slot.top;
+        if (++slot.generation == 0) slot.generation = 1;
+        Id id{index, slot.generation};
+        resume(index);
+        return id;
+    }
 
-        // Carregar texturas dos ícones de som
-        if (!soundOnTex.loadFromFile("assets/textures/sound_on.png")) {
-            cerr << "Erro ao carregar sound_on.png" << endl;
-        }
-        if (!soundOffTex.loadFromFile("assets/textures/sound_off.png")) {
-            cerr << "Erro ao carregar sound_off.png" << endl;
-        }
-        soundIcon.setTexture(soundOnTex);
-        soundIcon.setScale(0.12f, 0.12f);
-        soundIcon.setPosition(MOBILE_RESOLUTION_X - 80, 30);
+    // Nenhum roteiro vivo
+    bool idle() const {
+        return none_of(slots.begin(), slots.end(), [](const Slot& slot) { return bool(slot.top); });
+    }
 
-        // Configurar barra de volume
-        volumeBar.setSize(Vector2f(150, 15));
-        volumeBar.setFillColor(Color(100, 100, 100));
-        volumeBar.setPosition(50, 30);
-        
-        volumeFill.setSize(Vector2f(105, 15)); // 70% de volume inicial
-        volumeFill.setFillColor(Color(0, 200, 0));
-        volumeFill.setPosition(50, 30);
+    bool running(Id id) const {
+        return id.index < slots.size() && slots[id.index].generation == id.generation && slots[id.index].top;
+    }
 
-        // Carregar backgrounds
-        if (!bgCommunity.loadFromFile("assets/textures/bg_community.png")) {
-            cerr << "Erro ao carregar bg_community.png" << endl;
-        }
-        if (!bgIndustrial.loadFromFile("assets/textures/bg_industrial.png")) {
-            cerr << "Erro ao carregar bg_industrial.png" << endl;
-        }
-        if (!bgMegacenter.loadFromFile("assets/textures/bg_megacenter.png")) {
-            cerr << "Erro ao carregar bg_megacenter.png" << endl;
-        }
-        if (!bgBoss.loadFromFile("assets/textures/bg_boss.png")) {
-            cerr << "Erro ao carregar bg_boss.png" << endl;
-        }
-        
-        // Carregar texturas para retratos
-        if (!playerPortraitTex.loadFromFile("assets/textures/player_portrait.png")) {
-            cerr << "Erro ao carregar player_portrait.png" << endl;
-            // Fallback: criar textura verde
-            playerPortraitTex.create(50, 50);
-            Uint8* pixels = new Uint8[50 * 50 * 4];
-            fill(pixels, pixels + 50 * 50 * 4, 0);
-            for (int i = 0; i < 50 * 50 * 4; i += 4) {
-                pixels[i] = 0;    // R
-                pixels[i+1] = 200; // G
-                pixels[i+2] = 0;   // B
-                pixels[i+3] = 255; // A
-            }
-            playerPortraitTex.update(pixels);
-            delete[] pixels;
-        }
-        playerPortrait.setTexture(playerPortraitTex);
-        playerPortrait.setScale(0.05f, 0.05f);
-        
-        if (!bossPortraitTex.loadFromFile("assets/textures/boss_portrait.png")) {
-            cerr << "Erro ao carregar boss_portrait.png" << endl;
-            // Fallback: criar textura vermelha
-            bossPortraitTex.create(50, 50);
-            Uint8* pixels = new Uint8[50 * 50 * 4];
-            fill(pixels, pixels + 50 * 50 * 4, 0);
-            for (int i = 0; i < 50 * 50 * 4; i += 4) {
-                pixels[i]   = 200;   // R
-                pixels[i+1] = 0;   // G
-                pixels[i+2] = 0;   // B
-                pixels[i+3] = 255; // A
-            }
-            bossPortraitTex.update(pixels);
-            delete[] pixels;
-        }
-        bossPortrait.setTexture(bossPortraitTex);
-        if(!inBossIntro) {
-            bossPortrait.setScale(0.05f, 0.05f);
+    void stop(Id id) {
+        if (running(id)) release(id.index);
+    }
+
+    void clear() {
+        for (unsigned i = 0; i < slots.size(); ++i) {
+            if (slots[i].top) release(i);
         }
-        
-        bgSprite.setTexture(bgCommunity); // Começa na fase 1
-        bgSprite.setScale(
-            static_cast<float>(MOBILE_RESOLUTION_X) / bgSprite.getLocalBounds().width,
-            static_cast<float>(MOBILE_RESOLUTION_Y) / bgSprite.getLocalBounds().height
-        );
+        timers.clear();
+    }
 
-        // Botão de continuar (maior para touch)
-        continueButton.setSize(Vector2f(MOBILE_RESOLUTION_X * 0.6f, 100));
-        continueButton.setFillColor(Color(70, 130, 180));
-        continueButton.setPosition(MOBILE_RESOLUTION_X * 0.2f, MOBILE_RESOLUTION_Y * 0.7f);
+    // Avança um tick e acorda só os roteiros cujo tempo venceu
+    void tick() {
+        timers.advance([this](int, unsigned index) {
+            slots[index].timer = TimerWheel::Handle();
+            resume(index);
+        });
+    }
 
-        continueButtonText.setFont(font);
-        continueButtonText.setString("Continuar");
-        continueButtonText.setCharacterSize(36);
-        continueButtonText.setFillColor(Color::White);
-        FloatRect btnTextBounds = continueButtonText.getLocalBounds();
-        continueButtonText.setPosition(
-            MOBILE_RESOLUTION_X / 2 - btnTextBounds.width / 2,
-            MOBILE_RESOLUTION_Y * 0.7f + 35
-        );
+    // Acorda quem espera o sinal (e cuja condição, se houver, já vale)
+    void signal(int signal) {
+        if (signal >= static_cast<int>(waiters.size()) || waiters[signal].empty()) return;
+        vector<Waiter> ready;
+        ready.swap(waiters[signal]);
+        for (const Waiter& waiter : ready) {
+            Slot& slot = slots[waiter.index];
+            if (slot.generation != waiter.generation || slot.signal != signal) continue;
+            if (slot.check && !slot.check(slot.awaiter)) {
+                waiters[signal].push_back(waiter);
+                continue;
+            }
+            slot.signal = -1;
+            resume(waiter.index);
+        }
+        // Devolve a capacidade para a próxima espera
+        if (waiters[signal].empty()) {
+            ready.clear();
+            waiters[signal].swap(ready);
+        }
+    }
 
-        levelInfoText.setFont(font);
-        levelInfoText.setCharacterSize(36);
-        levelInfoText.setFillColor(Color::White);
-        levelInfoText.setStyle(Text::Bold);
-        levelInfoText.setPosition(50, MOBILE_RESOLUTION_Y * 0.3f);
+    struct Delay {
+        ScriptRunner& runner;
+        Uint64 ticks;
+        bool await_ready() const { return false; }
+        void await_suspend(Script::Handle h) { runner.parkTimer(h, ticks); }
+        void await_resume() const {}
+    };
 
-        // Configurar painel e texto para história
-        storyPanel.setSize(Vector2f(MOBILE_RESOLUTION_X * 0.9f, MOBILE_RESOLUTION_Y * 0.7f));
-        storyPanel.setFillColor(Color(0, 0, 0, 180));
-        storyPanel.setOutlineColor(Color::White);
-        storyPanel.setOutlineThickness(2);
-        storyPanel.setPosition(MOBILE_RESOLUTION_X * 0.05f, MOBILE_RESOLUTION_Y * 0.15f);
-        
-        storyText.setFont(font);
-        storyText.setCharacterSize(28);
-        storyText.setFillColor(Color::White);
-        storyText.setPosition(MOBILE_RESOLUTION_X * 0.1f, MOBILE_RESOLUTION_Y * 0.2f);
+    struct Wait {
+        ScriptRunner& runner;
+        int signal;
+        bool await_ready() const { return false; }
+        void await_suspend(Script::Handle h) { runner.parkSignal(h, signal, nullptr, nullptr); }
+        void await_resume() const {}
+    };
 
-        // Carregar sons de vitória e derrota
-        if (!victoryBuffer.loadFromFile("assets/sounds/victory.mp3")) {
-            cerr << "Erro ao carregar victory.wav" << endl;
+    // Não espera se a condição já vale
+    template <class Predicate>
+    struct WaitUntil {
+        ScriptRunner& runner;
+        int signal;
+        Predicate predicate;
+        bool await_ready() const { return predicate(); }
+        void await_suspend(Script::Handle h) {
+            runner.parkSignal(h, signal, [](const void* self) {
+                return static_cast<const WaitUntil*>(self)->predicate();
+            }, this);
         }
-        victorySound.setBuffer(victoryBuffer);
+        void await_resume() const {}
+    };
 
-        if (!defeatBuffer.loadFromFile("assets/sounds/defeat.wav")) {
-            cerr << "Erro ao carregar defeat.wav" << endl;
-        }
-        defeatSound.setBuffer(defeatBuffer);
+    Delay delay(float seconds) {
+        return Delay{*this, TimerWheel::ticksFor(seconds)};
+    }
 
-        // Configurar barras de vida para o boss fight
-        playerLifeBarBack.setSize(Vector2f(MOBILE_RESOLUTION_X * 0.8f, 30));
-        playerLifeBarBack.setFillColor(Color(200, 200, 200)); // Fundo cinza
-        playerLifeBarBack.setOutlineColor(Color::Black);
-        playerLifeBarBack.setOutlineThickness(2);
-        playerLifeBarBack.setPosition(MOBILE_RESOLUTION_X * 0.1f, MOBILE_RESOLUTION_Y * 0.9f);
-        
-        playerLifeBar.setSize(Vector2f(MOBILE_RESOLUTION_X * 0.8f, 30));
-        playerLifeBar.setFillColor(Color::Green);
-        playerLifeBar.setPosition(MOBILE_RESOLUTION_X * 0.1f, MOBILE_RESOLUTION_Y * 0.9f);
+    Delay delayTicks(Uint64 ticks) {
+        return Delay{*this, ticks};
+    }
 
-        bossLifeBarBack.setSize(Vector2f(MOBILE_RESOLUTION_X * 0.8f, 30));
-        bossLifeBarBack.setFillColor(Color(200, 200, 200)); // Fundo cinza
-        bossLifeBarBack.setOutlineColor(Color::Black);
-        bossLifeBarBack.setOutlineThickness(2);
-        bossLifeBarBack.setPosition(MOBILE_RESOLUTION_X * 0.1f, 50);
-        
-        bossLifeBar.setSize(Vector2f(MOBILE_RESOLUTION_X * 0.8f, 30));
-        bossLifeBar.setFillColor(Color::Red);
-        bossLifeBar.setPosition(MOBILE_RESOLUTION_X * 0.1f, 50);
+    Wait wait(int signal) {
+        return Wait{*this, signal};
     }
 
-    void setupTexts() {
-        scoreText.setFont(font);
-        scoreText.setCharacterSize(36);
-        scoreText.setFillColor(Color::White);
-        scoreText.setPosition(20, 20);
-
-        phaseText.setFont(font);
-        phaseText.setCharacterSize(32);
-        phaseText.setFillColor(Color::White);
-        phaseText.setPosition(20, 70);
-
-        messageText.setFont(font);
-        messageText.setCharacterSize(42);
-        messageText.setFillColor(Color::Red);
-        messageText.setPosition(MOBILE_RESOLUTION_X / 2, MOBILE_RESOLUTION_Y / 2);
-        messageText.setStyle(Text::Bold);
-        messageText.setOrigin(messageText.getLocalBounds().width / 2, 0);
-
-        reputationText.setFont(font);
-        reputationText.setCharacterSize(32);
-        reputationText.setFillColor(Color::White);
-        reputationText.setPosition(MOBILE_RESOLUTION_X * 0.65f, 40);
-
-        comboText.setFont(font);
-        comboText.setCharacterSize(36);
-        comboText.setFillColor(Color::White);
-        comboText.setPosition(20, 120);
-
-        comboMultiplierText.setFont(font);
-        comboMultiplierText.setCharacterSize(36);
-        comboMultiplierText.setFillColor(Color::Yellow);
-        comboMultiplierText.setStyle(Text::Bold);
-        comboMultiplierText.setPosition(150, 120);
+    template <class Predicate>
+    WaitUntil<Predicate> waitUntil(int signal, Predicate predicate) {
+        return WaitUntil<Predicate>{*this, signal, predicate};
+    }
 
-        // Configurações para a tela inicial
-        gameTitle.setFont(font);
-        gameTitle.setString("Gerenciador de Reciclagem");
-        gameTitle.setCharacterSize(48);
-        gameTitle.setFillColor(Color::White);
-        FloatRect titleBounds = gameTitle.getLocalBounds();
-        gameTitle.setPosition(MOBILE_RESOLUTION_X / 2 - titleBounds.width / 2, MOBILE_RESOLUTION_Y * 0.2f);
+private:
+    struct Slot {
+        Script::Handle top;         // Dono do quadro da corrotina
+        coroutine_handle<> waiting; // Onde está suspenso (pode ser um sub-roteiro)
+        unsigned generation = 0;
+        TimerWheel::Handle timer;
+        int signal = -1;
+        bool (*check)(const void*) = nullptr;
+        const void* awaiter = nullptr;
+    };
 
-        startButton.setSize(Vector2f(MOBILE_RESOLUTION_X * 0.6f, 120));
-        startButton.setFillColor(Color(70, 130, 180));
-        startButton.setPosition(MOBILE_RESOLUTION_X * 0.2f, MOBILE_RESOLUTION_Y * 0.5f);
+    struct Waiter {
+        unsigned index;
+        unsigned generation;
+    };
 
-        startButtonText.setFont(font);
-        startButtonText.setString("Comecar");
-        startButtonText.setCharacterSize(42);
-        startButtonText.setFillColor(Color::White);
-        FloatRect btnTextBounds = startButtonText.getLocalBounds();
-        startButtonText.setPosition(
-            MOBILE_RESOLUTION_X / 2 - btnTextBounds.width / 2,
-            MOBILE_RESOLUTION_Y * 0.5f + 40
-        );
+    vector<Slot> slots;
+    vector<unsigned> freeSlots;
+    vector<vector<Waiter>> waiters; // Por sinal
+    TimerWheel timers;
+
+    void parkTimer(Script::Handle h, Uint64 ticks) {
+        Slot& slot = slots[h.promise().slot];
+        slot.waiting = h;
+        slot.timer = timers.schedule(ticks, 0, h.promise().slot);
     }
 
-    void loadTextures() {
-        vector<string> textureFiles = {
-            "assets/textures/paper.png",
-            "assets/textures/plastic.png",
-            "assets/textures/metal.png",
-            "assets/textures/glass.png",
-            "assets/textures/organic.png",
-            "assets/textures/electronic.png",
-            "assets/textures/battery.png"
-        };
+    void parkSignal(Script::Handle h, int signal, bool (*check)(const void*), const void* awaiter) {
+        unsigned index = h.promise().slot;
+        Slot& slot = slots[index];
+        slot.waiting = h;
+        slot.signal = signal;
+        slot.check = check;
+        slot.awaiter = awaiter;
+        if (signal >= static_cast<int>(waiters.size())) {
+            waiters.resize(signal + 1);
+        }
+        waiters[signal].push_back(Waiter{index, slot.generation});
+    }
 
-        for (const auto& file : textureFiles) {
-            Texture tex;
-            if (!tex.loadFromFile(file)) {
-                cerr << "Erro ao carregar textura: " << file << endl;
-                // Cria textura cor de rosa para debug
-                tex.create(50, 50);
-                Uint8* pixels = new Uint8[50 * 50 * 4];
-                for (int i = 0; i < 50*50*4; i += 4) {
-                    pixels[i]   = 255; // R
-                    pixels[i+1] = 0;   // G
-                    pixels[i+2] = 255; // B
-                    pixels[i+3] = 255; // A
-                }
-                tex.update(pixels);
-                delete[] pixels;
-            }
-            wasteTextures.push_back(tex);
+    void resume(unsigned index) {
+        slots[index].waiting.resume();
+        if (slots[index].top && slots[index].top.done()) {
+            release(index);
         }
     }
 
-    // Carrega as texturas das lixeiras UMA ÚNICA VEZ
-    void loadBinTextures() {
-        vector<pair<WasteType, string>> binFiles = {
-            {PAPER,      "assets/textures/paperbin.png"},
-            {PLASTIC,    "assets/textures/plasticbin.png"},
-            {METAL,      "assets/textures/metalbin.png"},
-            {GLASS,      "assets/textures/glassbin.png"},
-            {ORGANIC,    "assets/textures/organicbin.png"},
-            {ELECTRONIC, "assets/textures/electronicbin.png"},
-            {BATTERY,    "assets/textures/batterybin.png"}
-        };
+    void release(unsigned index) {
+        Slot& slot = slots[index];
+        timers.cancel(slot.timer);
+        if (slot.signal >= 0) {
+            vector<Waiter>& list = waiters[slot.signal];
+            list.erase(remove_if(list.begin(), list.end(), [&](const Waiter& w) {
+                return w.index == index && w.generation == slot.generation;
+            }), list.end());
+        }
+        Script::Handle top = slot.top;
+        unsigned generation = slot.generation;
+        slot = Slot();
+        slot.generation = generation;
+        freeSlots.push_back(index);
+        // Por último: o quadro leva junto os sub-roteiros em andamento
+        top.destroy();
+    }
+};
+
+// --- Sorteios ---
+// A simulação sorteia direto da saída do gerador. As distribuições da
+// biblioteca padrão são livres para mudar de uma implementação para outra,
+// e as duas máquinas do versus (e os replays) precisam tirar os mesmos
+// números com qualquer compilador.
+template <class Generator>
+int drawInt(Generator& generator, int n) {
+    const Uint64 range = static_cast<Uint64>(Generator::max() - Generator::min()) + 1;
+    const Uint64 limit = range - range % n; // Descarta a sobra: sem viés para os primeiros valores
+    Uint64 value;
+    do {
+        value = generator() - Generator::min();
+    } while (value >= limit);
+    return static_cast<int>(value % n);
+}
+
+// Em [0, 1), passo de 2^-24 (todos exatos num float)
+template <class Generator>
+float drawUnit(Generator& generator) {
+    return drawInt(generator, 1 << 24) / 16777216.0f;
+}
+
+// --- Trajetórias ---
+// Ondas do boss descem em curva. A curva é amostrada uma única vez, quando
+// a onda nasce, numa tabela de deslocamentos. A cada tick a onda avança na
+// tabela e todos os membros andam o mesmo tanto: sem seno nem spline por
+// resíduo, só uma interpolação por onda e uma soma por membro.
+#define PATH_SAMPLES 64        // Amostras por curva, igualmente espaçadas no tempo
+#define PATH_SPLINE_POINTS 5   // Pontos de controle sorteados da spline
+#define WAVE_SPACING 90.0f     // Distância horizontal entre membros de uma onda
+
+enum PathShape {
+    PATH_SINE,   // Zigue-zague
+    PATH_SPIRAL, // Gira enquanto desce
+    PATH_SPLINE, // Curva suave por pontos sorteados
+    PATH_SHAPE_COUNT
+};
+
+struct PathTable {
+    Vector2f offsets[PATH_SAMPLES + 1]; // Do ponto de partida; começa em (0, 0) e desce fall pixels
+
+    // progress em [0, PATH_SAMPLES]
+    Vector2f at(float progress) const {
+        int i = min(static_cast<int>(progress), PATH_SAMPLES - 1);
+        float f = progress - i;
+        return offsets[i] + (offsets[i + 1] - offsets[i]) * f;
+    }
+
+    template <class Generator>
+    static PathTable build(PathShape shape, float fall, float amplitude, Generator& generator) {
+        PathTable table;
+        float controlX[PATH_SPLINE_POINTS];
+        if (shape == PATH_SPLINE) {
+            controlX[0] = 0.0f;
+            for (int k = 1; k < PATH_SPLINE_POINTS; ++k) {
+                int span = static_cast<int>(amplitude) * 2 + 1;
+                controlX[k] = drawInt(generator, span) - amplitude;
+            }
+        }
+        for (int i = 0; i <= PATH_SAMPLES; ++i) {
+            float t = static_cast<float>(i) / PATH_SAMPLES;
+            Vector2f& offset = table.offsets[i];
+            switch (shape) {
+                case PATH_SINE:
+                    offset = Vector2f(sin(t * 2 * 6.2831853f) * amplitude, t * fall);
+                    break;
+
+                case PATH_SPIRAL: {
+                    // Três voltas, fechando o raio até a metade
+                    float angle = t * 3 * 6.2831853f;
+                    float radius = amplitude * (1.0f - t * 0.5f);
+                    offset = Vector2f(sin(angle) * radius, t * fall + (1.0f - cos(angle)) * radius * 0.5f);
+                    break;
+                }
 
-        for (const auto& [type, file] : binFiles) {
-            Texture tex;
-            if (!tex.loadFromFile(file)) {
-                cerr << "Erro ao carregar textura da lixeira: " << file << endl;
-                // Cria textura de fallback
-                tex.create(70, 100);
-                Uint8* pixels = new Uint8[70*100*4];
-                for (int i = 0; i < 70*100*4; i += 4) {
-                    pixels[i]   = 0;   // R
-                    pixels[i+1] = 150; // G
-                    pixels[i+2] = 0;   // B
-                    pixels[i+3] = 255; // A
+                case PATH_SPLINE:
+                default: {
+                    // Catmull-Rom pelos pontos de controle, repetindo as pontas
+                    float segment = t * (PATH_SPLINE_POINTS - 1);
+                    int k = min(static_cast<int>(segment), PATH_SPLINE_POINTS - 2);
+                    float u = segment - k;
+                    float p0 = controlX[max(k - 1, 0)];
+                    float p1 = controlX[k];
+                    float p2 = controlX[k + 1];
+                    float p3 = controlX[min(k + 2, PATH_SPLINE_POINTS - 1)];
+                    float x = 0.5f * (2 * p1 + (p2 - p0) * u + (2 * p0 - 5 * p1 + 4 * p2 - p3) * u * u +
+                                      (3 * p1 - p0 - 3 * p2 + p3) * u * u * u);
+                    offset = Vector2f(x, t * fall);
+                    break;
                 }
-                tex.update(pixels);
-                delete[] pixels;
             }
-            binTextures[type] = tex;
         }
+        return table;
     }
+};
 
-    void loadPowerUpTextures() {
-        vector<string> powerUpFiles = {
-            "assets/textures/combo_boost.png",
-            "assets/textures/time_freeze.png",
-            "assets/textures/magnet.png",
-            "assets/textures/shield.png",
-            "assets/textures/boss_damage.png" // Novo ícone para dano ao boss
-        };
+struct WasteWave {
+    PathTable path;
+    float progress = 0.0f; // Posição na tabela
+    float rate = 0.0f;     // Amostras por tick com o tempo normal
+    Vector2f delta;        // Quanto cada membro anda neste tick
+    bool active = false;   // Slot livre quando falso
+};
 
-        for (const auto& file : powerUpFiles) {
-            Texture tex;
-            if (!tex.loadFromFile(file)) {
-                cerr << "Erro ao carregar textura do power-up: " << file << endl;
-                // Cria textura de fallback
-                tex.create(50, 50);
-                Uint8* pixels = new Uint8[50 * 50 * 4];
-                for (int i = 0; i < 50 * 50 * 4; i += 4) {
-                    pixels[i] = 255;     // R
-                    pixels[i + 1] = 255; // G
-                    pixels[i + 2] = 0;   // B
-                    pixels[i + 3] = 255; // A
-                }
-                tex.update(pixels);
-                delete[] pixels;
+// --- Waste ---
+class Waste {
+public:
+    unsigned id; // Identificador estável (índices mudam ao remover resíduos)
+    WasteType type;
+    Vector2f position; // Canto superior esquerdo do sprite
+    Vector2f velocity;
+    bool active;
+    bool selected;
+    bool magnetized; // Em linha reta até a lixeira, com chegada agendada
+    bool dragged;    // Preso ao dedo/mouse; não cai enquanto isso
+    int wave;        // Onda do boss que o move (Simulation::waves), ou -1 para cair em linha reta
+
+    Waste(unsigned i, WasteType t, float x, float speed) : id(i), type(t), position(x, -50), velocity(0, speed),
+                                                           active(true), selected(false), magnetized(false), dragged(false),
+                                                           wave(-1) {}
+
+    // Anda step (velocity ou o passo da onda); retorna true se passou do limite
+    bool update(Vector2f step) {
+        if (dragged) return false;
+        position += step;
+        if (position.y > MOBILE_RESOLUTION_Y - 200) {
+            active = false;
+            return true;
+        }
+        return false;
+    }
+};
+
+class PowerUp {
+public:
+    enum Type {
+        COMBO_BOOST,
+        TIME_FREEZE,
+        MAGNET,
+        SHIELD,
+        BOSS_DAMAGE // Novo power-up para atacar o boss
+    };
+
+    unsigned id;
+    Type type;
+    Vector2f position; // Centro do brilho
+    bool active;
+    TimerWheel::Handle expireTimer; // Vence após 10 segundos na tela
+
+    PowerUp(unsigned i, Type t, float x) : id(i), type(t), position(x + 35, -50 + 35), active(true) {}
+
+    // Área de toque: o círculo de brilho (raio 48), maior e mais fácil de clicar
+    FloatRect bounds() const {
+        return FloatRect(position.x - 48.0f, position.y - 48.0f, 96.0f, 96.0f);
+    }
+
+    // Atualiza a posição; o tempo de vida fica na TimerWheel
+    bool update() {
+        position.y += 2.0f; // Velocidade fixa
+
+        if (position.y > MOBILE_RESOLUTION_Y - 200) {
+            active = false;
+            return true; // Indica que o power-up deve ser removido
+        }
+        return false;
+    }
+};
+
+// --- Textos ---
+// Todo texto que o jogador vê tem um id. O português fica nesta tabela e
+// vale quando não há catálogo (ou falta uma chave nele); outros idiomas vêm
+// de um catálogo compilado (Catalog). A chave identifica o texto no arquivo
+// e o estilo é o tamanho em que ele aparece, para o layout ficar pronto no
+// carregamento. Tamanho 0: só entra formatado em outro texto ou no HUD.
+enum MessageId {
+    MSG_GAME_TITLE,
+    MSG_START,
+    MSG_VOLUME,
+    MSG_CONTINUE,
+    MSG_INTRO_STORY,
+    MSG_BOSS_STORY,
+    MSG_DEFEAT,
+    MSG_PHASE_COMPLETE,
+    MSG_BOSS_AHEAD,
+    MSG_BOSS_DEFEATED,
+    MSG_BOSS_LOST,
+    MSG_PHASE_LABEL, // %s: nome da fase (MSG_PHASE_COMMUNITY + fase)
+    MSG_PHASE_COMMUNITY,
+    MSG_PHASE_INDUSTRIAL,
+    MSG_PHASE_MEGACENTER,
+    MSG_PHASE_BOSS,
+    MSG_BIN_PAPER, // Na ordem de WasteType
+    MSG_BIN_PLASTIC,
+    MSG_BIN_METAL,
+    MSG_BIN_GLASS,
+    MSG_BIN_ORGANIC,
+    MSG_BIN_ELECTRONIC,
+    MSG_BIN_BATTERY,
+    MSG_SHIELD_ABSORBED,
+    MSG_EVENT_STRIKE,
+    MSG_EVENT_RAIN,
+    MSG_EVENT_FAILURE,
+    MSG_BOSS_ATTACK,
+    MSG_COMBO_BOOST,
+    MSG_TIME_FREEZE,
+    MSG_MAGNET,
+    MSG_SHIELD,
+    MSG_BOSS_RAGE,
+    MSG_BOSS_BURST,
+    MSG_VERSUS_WIN,
+    MSG_VERSUS_LOSS,
+    MSG_VERSUS_DRAW,
+    MSG_VERSUS_DISCONNECTED,
+    MSG_VERSUS_DESYNC,
+    MSG_VERSUS_RESULT, // %s: um dos cinco acima
+    MSG_HUD_SCORE,     // HUD: só ASCII, desenhado pelo atlas
+    MSG_HUD_COMBO,
+    MSG_HUD_REPUTATION,
+    MSG_HUD_RIVAL,
+    MSG_COUNT
+};
+
+struct MessageInfo {
+    const char* key;
+    const char* text; // UTF-8
+    unsigned size;
+    bool bold;
+};
+
+const MessageInfo MESSAGES[] = {
+    {"game_title", "Gerenciador de Reciclagem", 48, false},
+    {"start", "Comecar", 42, false},
+    {"volume", "Volume", 24, false},
+    {"continue", "Continuar", 36, false},
+    {"intro_story",
+        "Bem-vindo ao Gerenciador de Reciclagem!\n\n"
+        "Voce e o novo coletor de lixo da cidade.\n"
+        "Nosso planeta esta sendo sufocado por residuos,\n"
+        "e cabe a voce organizar a coleta seletiva.\n\n"
+        "Sua missao:\n"
+        "Classificar corretamente os residuos que estao caindo\n"
+        "dos caminhoes de coleta antes que poluam a cidade.\n\n"
+        "Cada acerto aumenta sua reputacao e pontos.\n"
+        "Erros ou residuos perdidos diminuem sua reputacao.\n\n"
+        "Toque para comecar sua jornada!", 28, false},
+    {"boss_story",
+        "BOSS FINAL: A INDUSTRIA POLUIDORA\n\n"
+        "Voce chegou ao desafio final!\n"
+        "A Industria Poluidora, liderada pelo CEO Ganancioso,\n"
+        "esta despejando residuos toxicos em massa!\n\n"
+        "Sua missao agora e pessoal:\n"
+        "Derrote a Industria Poluidora antes que ela destrua\n"
+        "todos os seus esforcos de reciclagem!\n\n"
+        "Diferente das fases anteriores:\n"
+        "- Cada erro reduz sua barra de vida\n"
+        "- Acertos recuperam um pouco de vida\n"
+        "- A cada 5 acertos, aparece um power-up especial\n"
+        "  que pode causar dano direto ao boss\n\n\n"
+        "Toque para comecar o combate final!", 28, false},
+    {"defeat", "Derrota!\nSua reputacao chegou a zero.\nToque para voltar ao menu.", 42, true},
+    {"phase_complete", "Fase %d completa!\nPontuacao: %d\nReputacao: %d%%", 36, true},
+    {"boss_ahead", "Boss Fight!\nPrepare-se para o desafio final!", 36, true},
+    {"boss_defeated", "Parabéns! Você derrotou o Boss!", 36, true},
+    {"boss_lost", "Você perdeu para o Boss!", 42, true},
+    {"phase_label", "Fase: %s", 32, false},
+    {"phase_community", "Centro Comunitario", 0, false},
+    {"phase_industrial", "Expansao Industrial", 0, false},
+    {"phase_megacenter", "Megacentro Urbano", 0, false},
+    {"phase_boss", "BOSS FINAL", 0, false},
+    {"bin_paper", "Papel", 24, false},
+    {"bin_plastic", "Plastico", 24, false},
+    {"bin_metal", "Metal", 24, false},
+    {"bin_glass", "Vidro", 24, false},
+    {"bin_organic", "Organico", 24, false},
+    {"bin_electronic", "Eletronico", 24, false},
+    {"bin_battery", "Bateria", 24, false},
+    {"shield_absorbed", "Escudo absorveu o erro! (%d restantes)", 42, true},
+    {"event_strike", "Greve dos coletores! Velocidade aumentada!", 42, true},
+    {"event_rain", "Chuva forte! Residuos perigosos aparecendo!", 42, true},
+    {"event_failure", "Falha no sistema! Combos resetados!", 42, true},
+    {"boss_attack", "Ataque no Boss! -%d HP", 42, true},
+    {"combo_boost", "Combo Boost Ativado! Pontos triplicados!", 42, true},
+    {"time_freeze", "Time Freeze Ativado! Velocidade reduzida!", 42, true},
+    {"magnet", "Magnet Ativado! Residuos sendo atraidos!", 42, true},
+    {"shield", "Shield Ativado! +3 escudos de protecao!", 42, true},
+    {"boss_rage", "O Boss esta furioso!", 42, true},
+    {"boss_burst", "Rajada de baterias!", 42, true},
+    {"versus_win", "Vitoria!", 0, false},
+    {"versus_loss", "Derrota!", 0, false},
+    {"versus_draw", "Empate!", 0, false},
+    {"versus_disconnected", "Conexao perdida.", 0, false},
+    {"versus_desync", "Partidas dessincronizadas.", 0, false},
+    {"versus_result", "%s\nVoce: %d | Rival: %d\nToque para sair.", 42, true},
+    {"hud_score", "Pontuacao: %d", 0, false},
+    {"hud_combo", "Combo: %d", 0, false},
+    {"hud_reputation", "Reputacao: %d%%", 0, false},
+    {"hud_rival", "Rival: %d %d%%", 0, false}
+};
+static_assert(sizeof(MESSAGES) / sizeof(MESSAGES[0]) == MSG_COUNT, "MESSAGES fora de ordem com MessageId");
+
+// --- Modificadores ---
+// Eventos empilham modificadores com prazo; um temporizador MODIFIER_END
+// tira cada um da pilha. A pilha só é dobrada de novo quando muda, e a cada
+// tick o resultado recebe os power-ups ativos num único conjunto de fatores
+// (Simulation::effective); quedas, ondas, magnet, spawn e pontuação só leem
+// esse conjunto, em vez de cada evento mexer nos resíduos um a um.
+struct Modifiers {
+    float speed = 1.0f;     // Movimento dos resíduos: quedas, ondas do boss e magnet
+    float spawnRate = 1.0f; // Resíduos por segundo
+    float score = 1.0f;     // Pontos por acerto
+    float hazard = 0.0f;    // Chance de um resíduo novo ser eletrônico ou bateria
+
+    void apply(const Modifiers& other) {
+        speed *= other.speed;
+        spawnRate *= other.spawnRate;
+        score *= other.score;
+        hazard = max(hazard, other.hazard); // Chance não multiplica: vale a maior
+    }
+};
+
+struct TimedModifier {
+    Modifiers factors;
+    TimerWheel::Handle timer; // MODIFIER_END; payload: índice na pilha
+    bool active = false;      // Vaga livre para o próximo evento
+};
+
+// Eventos especiais do megacentro
+enum SpecialEventType {
+    EVENT_STRIKE,
+    EVENT_RAIN,
+    EVENT_FAILURE,
+    SPECIAL_EVENT_COUNT
+};
+
+struct SpecialEventDef {
+    MessageId message;
+    float seconds;       // Tempo dos modificadores na pilha (0: sem modificadores)
+    Modifiers modifiers;
+    bool resetCombo;     // Efeito na hora
+};
+
+const SpecialEventDef SPECIAL_EVENTS[SPECIAL_EVENT_COUNT] = {
+    {MSG_EVENT_STRIKE, 6.0f, {1.5f, 1.0f, 1.0f, 0.0f}, false}, // Tudo cai mais rápido
+    {MSG_EVENT_RAIN, 6.0f, {1.0f, 2.0f, 1.0f, 0.5f}, false},   // O dobro de resíduos, metade perigosos
+    {MSG_EVENT_FAILURE, 0.0f, Modifiers(), true}
+};
+
+// Acontecimentos da simulação que a apresentação (som, textos, telas) consome
+struct SimEvent {
+    enum Type {
+        WASTE_SELECTED,
+        CORRECT_SORT,
+        WRONG_SORT,
+        WASTE_MISSED,
+        SHIELD_ABSORBED,
+        MAGNET_COLLECTED,
+        POWERUP_USED,
+        BOSS_HIT,
+        MESSAGE,
+        PHASE_COMPLETE,
+        DEFEAT
+    };
+
+    Type type;
+    Vector2f position;
+    MessageId message; // MESSAGE: o que mostrar, no idioma do Game
+    int value;         // Argumento do texto (%d, ou a fase no %s de MSG_PHASE_LABEL)
+    Color color;
+};
+
+// --- Simulation ---
+// Regras do jogo sem janela, texturas ou áudio. O Game desenha e toca sons
+// a partir dela; o modo em lote roda milhares de instâncias em paralelo.
+class Simulation {
+public:
+    BalanceParams params;
+    SpriteMetrics metrics;
+    mt19937 rng;
+    minstd_rand garbageRng; // Só para os resíduos do versus: o fluxo normal dos dois tabuleiros segue igual
+
+    vector<Waste> activeWastes;
+    vector<PowerUp> activePowerUps;
+    vector<WasteType> binTypes;
+    vector<Vector2f> binPositions;
+    map<WasteType, FloatRect> binBounds;
+    vector<SimEvent> events;
+
+    int score;
+    int reputation;
+    int phase;
+    int combo;
+    bool specialEvent; // Aviso do evento na tela
+    int selectedWasteIndex;
+
+    // Arrastar e soltar: o resíduo segue o ponteiro e a soltura é resolvida
+    // contra as lixeiras. Sem passar do TOUCH_THRESHOLD, vale como toque.
+    bool dragging;
+    unsigned draggedWasteId;
+    Vector2f dragOffset; // Do ponto tocado ao canto do sprite
+    Vector2f dragStart;
+    bool dragMoved;
+
+    // Todos os temporizadores da partida, em ticks de simulação
+    enum TimerKind {
+        SPAWN_WASTE,
+        POWERUP_ROLL,
+        EVENT_ROLL,
+        EVENT_END,
+        COMBO_TIMEOUT,
+        TIME_FREEZE_END,
+        COMBO_BOOST_END,
+        MAGNET_END,
+        POWERUP_EXPIRE, // payload: id do power-up
+        MODIFIER_END    // payload: índice em modifiers
+    };
+    TimerWheel timers;
+    TimerWheel::Handle spawnTimer;
+    TimerWheel::Handle eventTimer;
+    TimerWheel::Handle comboTimer; // Zera o combo sem acertos
+    bool spawnPending; // Intervalo venceu com a tela cheia; spawna quando abrir vaga
+    // Ataques do boss. A cópia da Simulation (rollback do versus, que não
+    // tem boss) não leva roteiros: copiar com algum rodando é erro, não perda.
+    struct Scripts : ScriptRunner {
+        Scripts() = default;
+        Scripts(const Scripts& other) : ScriptRunner() { other.requireIdle(); }
+        Scripts& operator=(const Scripts& other) {
+            requireIdle();
+            other.requireIdle();
+            return *this;
+        }
+        void requireIdle() const {
+            if (!idle()) {
+                cerr << "Erro ao copiar simulacao: roteiros do boss rodando" << endl;
+                abort();
             }
-            powerUpTextures.push_back(tex);
         }
+    } scripts;
+    vector<WasteWave> waves; // Ondas em curva do boss; Waste::wave indexa aqui
+    enum ScriptSignal {
+        SIGNAL_BOSS_HIT
+    };
+    int garbagePending; // Resíduos extras do adversário no versus, spawnados no próximo tick
+    Uint64 phaseStartTick;
+    unsigned nextPowerUpId;
+
+    vector<TimedModifier> modifiers; // Pilha dos eventos
+    Modifiers stacked;               // Pilha dobrada em foldModifiers(), só quando ela muda
+    Modifiers effective;             // stacked com os power-ups, a cada tick
+
+    // Efeitos de power-up ativos
+    float timeFreezeFactor;
+    TimerWheel::Handle timeFreezeTimer;
+    int shieldCount;
+    float comboBoostMultiplier;
+    TimerWheel::Handle comboBoostTimer;
+    bool magnetActive;
+    TimerWheel::Handle magnetTimer;
+
+    // Coleta do magnet agendada pela distância percorrida desde a ativação.
+    // Todos os resíduos atraídos andam MAGNET_SPEED * effective.speed por tick,
+    // então uma única distância acumulada serve de relógio para todos.
+    struct MagnetArrival {
+        float travel; // Valor de magnetTravel em que o resíduo chega à lixeira
+        unsigned wasteId;
+        bool operator>(const MagnetArrival& other) const { return travel > other.travel; }
+    };
+    priority_queue<MagnetArrival, vector<MagnetArrival>, greater<MagnetArrival>> magnetArrivals;
+    float magnetTravel;
+    unsigned nextWasteId;
+
+    // Fase do boss
+    bool inBossFight;
+    int playerLife;
+    int bossLife;
+    int correctHitsSinceLastBossPowerUp;
+
+    bool phaseComplete; // Fase concluída, aguardando advancePhase()
+    bool defeated;
+
+    Simulation(const BalanceParams& p = BalanceParams(), unsigned seed = 0) : params(p), rng(seed), garbageRng(seed + 1) {
+        reset();
+    }
+
+    int randomInt(int n) {
+        return drawInt(rng, n);
+    }
+
+    void reset() {
+        score = 0;
+        reputation = 100;
+        phase = 0;
+        combo = 0;
+        specialEvent = false;
+        modifiers.clear();
+        stacked = Modifiers();
+        effective = Modifiers();
+        selectedWasteIndex = -1;
+        dragging = false;
+        activeWastes.clear();
+        waves.clear();
+        activePowerUps.clear();
+        events.clear();
+        timeFreezeFactor = 1.0f;
+        shieldCount = 0;
+        comboBoostMultiplier = 1.0f;
+        magnetActive = false;
+        magnetArrivals = decltype(magnetArrivals)();
+        magnetTravel = 0.0f;
+        nextWasteId = 0;
+        inBossFight = false;
+        playerLife = 100;
+        bossLife = 100;
+        correctHitsSinceLastBossPowerUp = 0;
+        phaseComplete = false;
+        defeated = false;
+        nextPowerUpId = 0;
+        garbagePending = 0;
+
+        // Handles antigos apontariam para nós reaproveitados
+        scripts.clear();
+        timers.clear();
+        spawnTimer = eventTimer = comboTimer = TimerWheel::Handle();
+        timeFreezeTimer = comboBoostTimer = magnetTimer = TimerWheel::Handle();
+        timers.schedule(TimerWheel::ticksFor(params.powerUpSpawnPeriod), POWERUP_ROLL);
+
+        setupBins();
+        startPhase();
+    }
 
-        if (!powerUpBuffer.loadFromFile("assets/sounds/powerup.wav")) {
-            cerr << "Erro ao carregar som de power-up" << endl;
+    // Timers que dependem da fase e a escolha do tick especializado
+    void startPhase() {
+        const PhaseConfig& config = PHASE_CONFIGS[phase];
+        phaseStartTick = timers.now();
+        spawnPending = false;
+        restartTimer(spawnTimer, params.spawnIntervalBase - config.difficulty * params.spawnIntervalPerPhase, SPAWN_WASTE);
+        timers.cancel(eventTimer);
+        if (config.specialEvents) {
+            eventTimer = timers.schedule(TimerWheel::ticksFor(10.0f), EVENT_ROLL);
         }
-        powerUpSound.setBuffer(powerUpBuffer);
+        selectTickFunction();
+    }
+
+    void restartTimer(TimerWheel::Handle& handle, float seconds, TimerKind kind) {
+        timers.cancel(handle);
+        handle = timers.schedule(TimerWheel::ticksFor(seconds), kind);
+    }
+
+    float remainingSeconds(TimerWheel::Handle handle) const {
+        return timers.remaining(handle) * SIM_DT;
+    }
+
+    float gameTime() const {
+        return timers.now() * SIM_DT;
+    }
+
+    float phaseTime() const {
+        return (timers.now() - phaseStartTick) * SIM_DT;
+    }
+
+    float powerUpLifetime(const PowerUp& powerUp) const {
+        return remainingSeconds(powerUp.expireTimer);
     }
 
     void setupBins() {
-        bins.clear();
+        binTypes.clear();
+        binPositions.clear();
         binBounds.clear();
-        binLabels.clear(); // Limpa os textos antigos
 
         // Configuração das lixeiras de acordo com a fase
-        vector<WasteType> binTypes;
-        if (phase == COMMUNITY) {
-            binTypes = {PAPER, PLASTIC, METAL};
-        } else if (phase == INDUSTRIAL) {
-            binTypes = {PAPER, PLASTIC, METAL, GLASS, ORGANIC};
-        } else if (phase == MEGACENTER || phase == BOSS) { // Boss usa todas as lixeiras
-            binTypes = {PAPER, PLASTIC, METAL, GLASS, ORGANIC, ELECTRONIC, BATTERY};
-        }
+        const PhaseConfig& config = PHASE_CONFIGS[phase];
+        binTypes.assign(config.bins, config.bins + config.binCount);
 
-        float binWidth = 100.0f; // Aumentado para mobile
-        float spacing = (MOBILE_RESOLUTION_X - (binWidth * binTypes.size())) / (binTypes.size() + 1);
+        float spacing = (MOBILE_RESOLUTION_X - (BIN_WIDTH * binTypes.size())) / (binTypes.size() + 1);
+        float binY = config.binY;
 
-        // Ajuste da posição Y: na fase do boss, subir as lixeiras
-        float binY = MOBILE_RESOLUTION_Y - 250.0f; // Posicionado mais alto
-        if (phase == BOSS) {
-            binY = MOBILE_RESOLUTION_Y - 300.0f;
+        for (size_t i = 0; i < binTypes.size(); i++) {
+            WasteType type = binTypes[i];
+            float x = spacing + i * (BIN_WIDTH + spacing);
+            binPositions.push_back(Vector2f(x, binY));
+
+            // Aumentar área de toque
+            Vector2f size = metrics.binSize[type] * BIN_SCALE;
+            binBounds[type] = FloatRect(x - 15, binY - 15, size.x + 30, size.y + 30);
         }
+    }
 
-        for (int i = 0; i < binTypes.size(); i++) {
-            WasteType type = binTypes[i];
+    // Área de toque de um resíduo (sprite ampliado em 20px de cada lado)
+    FloatRect wasteBounds(const Waste& waste) const {
+        Vector2f size = metrics.wasteSize[waste.type] * WASTE_SCALE;
+        return FloatRect(waste.position.x - 20, waste.position.y - 20, size.x + 40, size.y + 40);
+    }
 
-            if (binTextures.find(type) == binTextures.end()) {
-                cerr << "Textura não encontrada para lixeira do tipo " << type << endl;
-                continue;
+    void pushEvent(SimEvent::Type type, Vector2f position = Vector2f()) {
+        events.push_back(SimEvent{type, position, MSG_COUNT, 0, Color::White});
+    }
+
+    void pushMessage(MessageId message, Color color, int value = 0) {
+        events.push_back(SimEvent{SimEvent::MESSAGE, Vector2f(), message, value, color});
+    }
+
+    template <GamePhase P>
+    void spawnWaste() {
+        spawnWasteFrom<P>(rng);
+    }
+
+    template <GamePhase P, class Generator>
+    void spawnWasteFrom(Generator& generator) {
+        constexpr const PhaseConfig& config = PHASE_CONFIGS[P];
+        WasteType type = static_cast<WasteType>(drawInt(generator, config.wasteTypeCount));
+        // Chuva forte: parte dos resíduos vira eletrônico ou bateria (o sorteio
+        // extra só acontece com o evento ativo, então o fluxo normal segue igual)
+        if constexpr (config.wasteTypeCount > BATTERY) {
+            if (effective.hazard > 0.0f && drawUnit(generator) < effective.hazard) {
+                type = drawInt(generator, 2) ? BATTERY : ELECTRONIC;
             }
+        }
+        spawnWasteOfType<P>(type, generator);
+    }
 
-            Sprite bin;
-            bin.setTexture(binTextures[type]);
-            bin.setScale(0.25f, 0.25f); // Aumentado para mobile
-            float x = spacing + i * (binWidth + spacing);
-            bin.setPosition(x, binY); // Usando binY
-            bins.push_back(bin);
-            
-            // Aumentar área de toque
-            FloatRect bounds = bin.getGlobalBounds();
-            bounds.left -= 15;
-            bounds.top -= 15;
-            bounds.width += 30;
-            bounds.height += 30;
-            binBounds[type] = bounds;
-
-            // Nome da lixeira
-            string label;
-            switch (type) {
-                case PAPER: label = "Papel"; break;
-                case PLASTIC: label = "Plastico"; break;
-                case METAL: label = "Metal"; break;
-                case GLASS: label = "Vidro"; break;
-                case ORGANIC: label = "Organico"; break;
-                case ELECTRONIC: label = "Eletronico"; break;
-                case BATTERY: label = "Bateria"; break;
-                default: label = "Lixeira"; break;
-            }
-            Text text;
-            text.setFont(font);
-            text.setString(label);
-            text.setCharacterSize(24); // Aumentado para mobile
-            text.setFillColor(Color::White);
-            text.setPosition(x + (binWidth * 0.1f), binY + 100); // Ajuste em Y também
-            binLabels.push_back(text);
+    template <GamePhase P, class Generator>
+    void spawnWasteOfType(WasteType type, Generator& generator) {
+        constexpr const PhaseConfig& config = PHASE_CONFIGS[P];
+        float x = static_cast<float>(drawInt(generator, MOBILE_RESOLUTION_X - 100));
+        // Velocidade ajustada: base + incremento por fase + aleatório
+        float speed = params.wasteBaseSpeed + config.difficulty * params.wasteSpeedPerPhase +
+                      drawInt(generator, 10) * params.wasteSpeedJitter;
+        activeWastes.push_back(Waste(nextWasteId++, type, x, speed));
+        if (magnetActive) {
+            scheduleMagnet(activeWastes.back());
         }
     }
 
-    void spawnWaste() {
-        WasteType type;
-        if (phase == COMMUNITY) {
-            type = static_cast<WasteType>(rand() % 3);
-        } else if (phase == INDUSTRIAL) {
-            type = static_cast<WasteType>(rand() % 5);
-        } else {
-            type = static_cast<WasteType>(rand() % 7);
+    // Onda de count resíduos lado a lado descendo pela mesma curva
+    template <GamePhase P>
+    void spawnWave(WasteType type, int count, PathShape shape) {
+        constexpr const PhaseConfig& config = PHASE_CONFIGS[P];
+        float speed = params.wasteBaseSpeed + config.difficulty * params.wasteSpeedPerPhase +
+                      randomInt(10) * params.wasteSpeedJitter;
+        float amplitude = params.bossWaveAmplitude;
+        float fall = MOBILE_RESOLUTION_Y - 100.0f; // De y = -50 até passar do limite
+
+        // Formação inteira dentro da tela, mesmo no ponto mais aberto da curva
+        float room = max(0.0f, MOBILE_RESOLUTION_X - 100 - 2 * amplitude);
+        float spacing = count > 1 ? min(WAVE_SPACING, room / (count - 1)) : 0.0f;
+        float x = amplitude + randomInt(static_cast<int>(room - spacing * (count - 1)) + 1);
+
+        size_t index = 0;
+        while (index < waves.size() && waves[index].active) ++index;
+        if (index == waves.size()) waves.emplace_back();
+        WasteWave& wave = waves[index];
+        wave.path = PathTable::build(shape, fall, amplitude, rng);
+        wave.progress = 0.0f;
+        wave.rate = PATH_SAMPLES * speed / fall; // Mesmo tempo de queda de um resíduo normal
+        wave.delta = Vector2f();
+        wave.active = true;
+
+        for (int i = 0; i < count; ++i) {
+            activeWastes.push_back(Waste(nextWasteId++, type, x + i * spacing, speed));
+            activeWastes.back().wave = static_cast<int>(index);
+            if (magnetActive) {
+                scheduleMagnet(activeWastes.back());
+            }
+        }
+    }
+
+    // Um passo na tabela por onda. No fim da curva os membros que restarem
+    // seguem caindo em linha reta e o slot fica livre.
+    void advanceWaves() {
+        for (size_t i = 0; i < waves.size(); ++i) {
+            WasteWave& wave = waves[i];
+            if (!wave.active) continue;
+            if (wave.progress >= PATH_SAMPLES) {
+                wave.active = false;
+                for (auto& waste : activeWastes) {
+                    if (waste.wave == static_cast<int>(i)) waste.wave = -1;
+                }
+                continue;
+            }
+            float next = min(wave.progress + wave.rate * effective.speed, static_cast<float>(PATH_SAMPLES));
+            wave.delta = wave.path.at(next) - wave.path.at(wave.progress);
+            wave.progress = next;
         }
-        // Passe a fase para ajustar velocidade
-        activeWastes.push_back(Waste(wasteTextures[type], type, phase));
+    }
+
+    void addPowerUp(PowerUp::Type type) {
+        PowerUp powerUp(nextPowerUpId++, type, static_cast<float>(randomInt(MOBILE_RESOLUTION_X - 100)));
+        powerUp.expireTimer = timers.schedule(TimerWheel::ticksFor(10.0f), POWERUP_EXPIRE, powerUp.id);
+        activePowerUps.push_back(powerUp);
     }
 
     void spawnPowerUp() {
-        PowerUp::Type type;
+        // Só sorteia power-ups normais; BOSS_DAMAGE é spawnado por acertos
+        addPowerUp(static_cast<PowerUp::Type>(randomInt(PowerUp::BOSS_DAMAGE)));
+    }
+
+    void spawnBossPowerUp() {
         if (phase == BOSS && inBossFight) {
-            // Só sorteia power-ups normais, exceto BOSS_DAMAGE (que é spawnado por acertos)
-            type = static_cast<PowerUp::Type>(rand() % (PowerUp::BOSS_DAMAGE)); // Não inclui BOSS_DAMAGE
-        } else {
-            type = static_cast<PowerUp::Type>(rand() % (PowerUp::BOSS_DAMAGE)); // Não inclui BOSS_DAMAGE
+            addPowerUp(PowerUp::BOSS_DAMAGE);
         }
-        activePowerUps.push_back(PowerUp(powerUpTextures[type], type));
     }
 
-    void update() {
-        float deltaTime = 1.0f / 60.0f;
-        spawnTimer += deltaTime;
-        gameTimer += deltaTime;
-        powerUpSpawnTimer += deltaTime;
+    void setDefeated() {
+        if (defeated) return;
+        defeated = true;
+        inBossFight = false;
+        pushEvent(SimEvent::DEFEAT);
+    }
+
+    typedef void (Simulation::*TickFunction)();
+    TickFunction tickFunction = nullptr;
+
+    // Única escolha por fase, feita ao entrar nela; o laço por tick não ramifica
+    void selectTickFunction() {
+        static constexpr TickFunction ticks[BOSS + 1] = {
+            &Simulation::tickPhase<COMMUNITY>,
+            &Simulation::tickPhase<INDUSTRIAL>,
+            &Simulation::tickPhase<MEGACENTER>,
+            &Simulation::tickPhase<BOSS>
+        };
+        tickFunction = ticks[phase];
+    }
+
+    // Avança um passo fixo de simulação (1/60 s)
+    void tick() {
+        if (phaseComplete || defeated) return;
+        (this->*tickFunction)();
+    }
+
+    template <GamePhase P>
+    void tickPhase() {
+        constexpr const PhaseConfig& config = PHASE_CONFIGS[P];
+        constexpr bool bossPhase = (P == BOSS);
+
+        // Disparar os temporizadores que vencem neste tick
+        timers.advance([this](int kind, unsigned payload) {
+            onTimer<P>(kind, payload);
+        });
+        scripts.tick();
 
         // Atualizar efeitos de power-ups
-        updatePowerUpEffects(deltaTime);
+        updatePowerUpEffects();
+        updateEffective();
+
+        // Coletar os resíduos que o magnet leva à lixeira neste tick
+        // (antes do movimento, para que nenhum passe do alvo)
+        updateMagnetArrivals();
 
         // Atualizar resíduos e verificar se algum passou do limite
+        if (bossPhase) {
+            advanceWaves();
+        }
         int wastesPassed = 0;
+        Vector2f missPosition;
         for (auto& waste : activeWastes) {
-            if (waste.update(timeFreezeFactor)) {
+            if (!waste.active) continue;
+            Vector2f step = waste.wave >= 0 ? waves[waste.wave].delta : waste.velocity * effective.speed;
+            if (waste.update(step)) {
                 wastesPassed++;
+                missPosition = waste.position;
             }
         }
 
         // Atualizar power-ups
         for (auto& powerUp : activePowerUps) {
-            if (powerUp.update(deltaTime)) {
-                powerUp.active = false;
-            }
-        }
-        
-        // Spawn de power-ups controlado por timer
-        if (powerUpSpawnTimer >= 3.0f) {
-            powerUpSpawnTimer = 0;
-            int chance = 0;
-            if (phase == COMMUNITY) {
-                chance = 30; // 30% na fase 1
-            } else if (phase == INDUSTRIAL) {
-                chance = 50; // 50% na fase 2
-            } else {
-                chance = 60; // 60% na fase 3
-            }
-            if (rand() % 100 < chance) {
-                spawnPowerUp();
+            if (powerUp.active && powerUp.update()) {
+                timers.cancel(powerUp.expireTimer);
             }
         }
 
@@ -735,27 +1490,20 @@ public:
             // CORREÇÃO: shield agora funciona na fase do boss também
             if (shieldCount > 0) {
                 shieldCount--;
-                messageText.setString("Escudo absorveu o erro! (" + to_string(shieldCount) + " restantes)");
-                messageText.setFillColor(Color::Blue);
-            } 
-            else if (inBossFight) {
+                pushMessage(MSG_SHIELD_ABSORBED, Color::Blue, shieldCount);
+                pushEvent(SimEvent::SHIELD_ABSORBED, missPosition);
+            }
+            else if (bossPhase && inBossFight) {
                 // Na fase do boss, lixo perdido causa dano ao jogador
-                playerLife = max(0, playerLife - wastesPassed * 10);
-                if (playerLife <= 0) {
-                    inDefeatScreen = true;
-                    inBossFight = false;
-                    messageText.setString("Você perdeu para o Boss!");
-                }
-            } 
+                playerLife = max(0, playerLife - wastesPassed * params.playerLifeMissPenalty);
+                pushEvent(SimEvent::WASTE_MISSED, missPosition);
+            }
             else {
-                reputation = max(0, reputation - wastesPassed * 7); // penalidade ajustada
+                reputation = max(0, reputation - wastesPassed * params.reputationMissPenalty);
                 combo = 0;
-                sound.setBuffer(wrongBuffer);
-                sound.play();
+                pushEvent(SimEvent::WASTE_MISSED, missPosition);
                 if (reputation <= 0) {
-                    bgMusic.pause();
-                    defeatSound.play();
-                    inDefeatScreen = true;
+                    setDefeated();
                 }
             }
         }
@@ -766,9 +1514,13 @@ public:
                 return !w.active;
             }), activeWastes.end());
 
-        // Corrige o índice do lixo selecionado se necessário
-        if (selectedWasteIndex >= static_cast<int>(activeWastes.size()) || selectedWasteIndex < 0) {
-            selectedWasteIndex = -1;
+        // Corrige o índice do lixo selecionado após a remoção
+        selectedWasteIndex = -1;
+        for (size_t i = 0; i < activeWastes.size(); ++i) {
+            if (activeWastes[i].selected) {
+                selectedWasteIndex = static_cast<int>(i);
+                break;
+            }
         }
 
         // Remover power-ups inativos
@@ -777,430 +1529,434 @@ public:
                 return !p.active;
             }), activePowerUps.end());
 
-        // Gerar novos resíduos
-        float spawnInterval = 2.0f - phase * 0.2f;
-        if (spawnTimer > spawnInterval && activeWastes.size() < 5 + phase * 2) {
-            spawnWaste();
-            spawnTimer = 0;
-        }
-
-        // Eventos especiais na fase 3
-        if (phase == MEGACENTER && !inBossFight) {
-            eventTimer += deltaTime;
-            if (eventTimer > 10.0f && !specialEvent) {
-                if (rand() % 100 < 30) {
-                    specialEvent = true;
-                    vector<string> events = {
-                        "Greve dos coletores! Velocidade aumentada!",
-                        "Chuva forte! Residuos perigosos aparecendo!",
-                        "Falha no sistema! Combos resetados!"
-                    };
-                    currentEvent = events[rand() % events.size()];
-                    messageText.setString(currentEvent);
-                    
-                    if (currentEvent.find("Velocidade") != string::npos) {
-                        for (auto& waste : activeWastes) {
-                            waste.velocity.y *= 1.5f;
-                        }
-                    }
-                    else if (currentEvent.find("Combos") != string::npos) {
-                        combo = 0;
-                    }
-                }
-                eventTimer = 0;
-            }
-            
-            if (specialEvent && eventTimer > 3.0f) {
-                specialEvent = false;
-            }
-        }
-
-        // Atualizar combo
-        if (combo > 0 && comboClock.getElapsedTime().asSeconds() > 5.0f) {
-            combo = 0;
+        // Gerar novos resíduos (o intervalo pode ter vencido com a tela cheia)
+        int maxWastes = params.maxWastesBase + config.difficulty * params.maxWastesPerPhase;
+        if (spawnPending && static_cast<int>(activeWastes.size()) < maxWastes) {
+            spawnWaste<P>();
+            spawnPending = false;
+            restartTimer(spawnTimer, (params.spawnIntervalBase - config.difficulty * params.spawnIntervalPerPhase) / effective.spawnRate,
+                         SPAWN_WASTE);
         }
 
-        // Atualizar textos
-        ostringstream ss;
-        ss << "Pontuacao: " << score;
-        scoreText.setString(ss.str());
-        
-        ss.str("");
-        ss << "Fase: ";
-        if (phase == COMMUNITY) ss << "Centro Comunitario";
-        else if (phase == INDUSTRIAL) ss << "Expansao Industrial";
-        else if (phase == MEGACENTER) ss << "Megacentro Urbano";
-        else ss << "BOSS FINAL";
-        phaseText.setString(ss.str());
-        
-        ss.str("");
-        ss << "Reputacao: " << reputation << "%";
-        reputationText.setString(ss.str());
-        
-        reputationBar.setSize(Vector2f(MOBILE_RESOLUTION_X * 0.3f * reputation / 100.0f, 25));
-        
-        // Atualizar combo text
-        ss.str("");
-        ss << "Combo: " << combo;
-        comboText.setString(ss.str());
-        
-        ss.str("");
-        ss << "x" << fixed << setprecision(1) << comboBoostMultiplier;
-        comboMultiplierText.setString(ss.str());
-        comboMultiplierText.setPosition(150 + comboText.getLocalBounds().width, 120);
-        
-        // Atualizar mensagens temporárias e animação do texto de power-up
-        if (!messageText.getString().isEmpty()) {
-            powerUpTextTimer += deltaTime;
-            // Fade out e movimento para cima
-            if (powerUpTextTimer > 0.5f) {
-                powerUpTextAlpha = max(0.0f, 255.0f - (powerUpTextTimer - 0.5f) * 255.0f);
-                powerUpTextY -= deltaTime * 30.0f; // Sobe lentamente
-                messageText.setFillColor(Color(
-                    messageText.getFillColor().r,
-                    messageText.getFillColor().g,
-                    messageText.getFillColor().b,
-                    static_cast<Uint8>(powerUpTextAlpha)
-                ));
-                messageText.setPosition(MOBILE_RESOLUTION_X / 2, powerUpTextY);
-            }
-            if (powerUpTextTimer > 1.5f) {
-                messageText.setString(""); // Limpa após 1.5 segundos
-                powerUpTextTimer = 0.0f;
-                powerUpTextAlpha = 255.0f;
-                powerUpTextY = MOBILE_RESOLUTION_Y / 2;
-            }
+        // Versus: resíduos mandados pelo adversário entram mesmo com a tela cheia
+        for (; garbagePending > 0; --garbagePending) {
+            spawnWasteFrom<P>(garbageRng);
         }
 
         // --- Verifica vitória/derrota do boss ---
-        if (inBossFight) {
+        if (bossPhase && inBossFight) {
             if (playerLife <= 0) {
-                inDefeatScreen = true;
-                inBossFight = false;
-                messageText.setString("Você perdeu para o Boss!");
+                setDefeated();
             } else if (bossLife <= 0) {
                 inBossFight = false;
-                inLevelTransition = true;
-                levelInfoText.setString("Parabéns! Você derrotou o Boss!");
-                bgMusic.pause();
-                victorySound.play();
+                phaseComplete = true;
+                pushEvent(SimEvent::PHASE_COMPLETE);
             }
         }
-    }
 
-    void updatePowerUpEffects(float deltaTime) {
-        // Atualizar efeito de congelamento
-        if (timeFreezeDuration > 0) {
-            timeFreezeDuration -= deltaTime;
-            
-            // Transição suave: 0-1 segundos: congelando, 4-5 segundos: descongelando
-            if (timeFreezeDuration > 4.0f) {
-                timeFreezeFactor = max(0.1f, 1.0f - (5.0f - timeFreezeDuration));
-            } else if (timeFreezeDuration < 1.0f) {
-                timeFreezeFactor = min(1.0f, timeFreezeDuration);
-            } else {
-                timeFreezeFactor = 0.1f;
-            }
-            
-            if (timeFreezeDuration <= 0) {
-                timeFreezeFactor = 1.0f;
-            }
-        }
-        
-        // Atualizar efeito de combo boost
-        if (comboBoostDuration > 0) {
-            comboBoostDuration -= deltaTime;
-            if (comboBoostDuration <= 0) {
-                comboBoostMultiplier = 1.0f;
+        // Meta de pontuação da fase
+        if constexpr (config.scoreTarget != nullptr) {
+            if (score >= params.*config.scoreTarget) {
+                phaseComplete = true;
+                pushEvent(SimEvent::PHASE_COMPLETE);
             }
         }
-        
-        // Atualizar efeito de magnet
-        if (magnetActive) {
-                magnetDuration -= deltaTime;
-                if (magnetDuration <= 0) {
-                    magnetActive = false;
-                } else {
-                    // Atrair resíduos para as lixeiras correspondentes
-                    for (auto& waste : activeWastes) {
-                        if (!waste.active) continue;
-                        if (binBounds.find(waste.type) != binBounds.end()) {
-                            FloatRect binRect = binBounds[waste.type];
-                            Vector2f target(binRect.left + binRect.width/2, binRect.top + binRect.height/2);
-
-                            // Move diretamente para o centro da lixeira se estiver próximo ou se magnet estiver ativo
-                            Vector2f direction = target - waste.sprite.getPosition();
-                            float distance = sqrt(direction.x*direction.x + direction.y*direction.y);
-
-                            // Se estiver longe, move gradualmente
-                            if (distance > 10.0f) {
-                                direction = direction / distance; // Normaliza
-                                waste.velocity = direction * 8.0f; // Move rápido para garantir acerto
-                            } else {
-                                // Coleta automaticamente
-                                waste.sprite.setPosition(target);
-                                int points = static_cast<int>(5 * comboBoostMultiplier);
-                                score += points;
-                                combo++;
-                                comboClock.restart();
-                                
-                                // Na fase do boss, acertos recuperam vida
-                                if (inBossFight) {
-                                    playerLife = min(100, playerLife + 5);
-                                } else {
-                                    reputation = min(100, reputation + 2);
-                                }
-                                
-                                waste.active = false;
-                                waste.sprite.setColor(Color(100, 250, 100)); // Verde claro
-                                sound.setBuffer(correctBuffer);
-                                sound.play();
-                            }
-                        }
-                    }
-                }
-        }
     }
 
-    void handleClick(Vector2f touchPos) {
-        // Se nenhum lixo está selecionado, procura por um para selecionar
-        if (selectedWasteIndex == -1) {
-            for (size_t i = 0; i < activeWastes.size(); ++i) {
-                // Aumentar área de toque para resíduos
-                FloatRect bounds = activeWastes[i].sprite.getGlobalBounds();
-                bounds.left -= 20;
-                bounds.top -= 20;
-                bounds.width += 40;
-                bounds.height += 40;
-                
-                if (bounds.contains(touchPos)) {
-                    selectedWasteIndex = static_cast<int>(i);
-                    activeWastes[i].sprite.setColor(Color(255, 255, 0));
-                    sound.setBuffer(selectBuffer);
-                    sound.play();
-                    break;
+    template <GamePhase P>
+    void onTimer(int kind, unsigned payload) {
+        constexpr const PhaseConfig& config = PHASE_CONFIGS[P];
+
+        switch (kind) {
+            case SPAWN_WASTE:
+                spawnPending = true;
+                break;
+
+            case POWERUP_ROLL:
+                // Spawn de power-ups controlado por timer
+                timers.schedule(TimerWheel::ticksFor(params.powerUpSpawnPeriod), POWERUP_ROLL);
+                if (randomInt(100) < params.*config.powerUpChance) {
+                    spawnPowerUp();
                 }
-            }
-        }
-        // Se já existe um lixo selecionado
-        else {
-            bool clickedAnotherWaste = false;
-            // Verifica se clicou em outro lixo
-            for (size_t i = 0; i < activeWastes.size(); ++i) {
-                // Aumentar área de toque para resíduos
-                FloatRect bounds = activeWastes[i].sprite.getGlobalBounds();
-                bounds.left -= 20;
-                bounds.top -= 20;
-                bounds.width += 40;
-                bounds.height += 40;
-                
-                if (bounds.contains(touchPos)) {
-                    // Remove destaque do anterior
-                    if (selectedWasteIndex >= 0 && selectedWasteIndex < static_cast<int>(activeWastes.size())) {
-                        activeWastes[selectedWasteIndex].sprite.setColor(Color::White);
-                    }
-                    // Seleciona o novo
-                    selectedWasteIndex = static_cast<int>(i);
-                    activeWastes[i].sprite.setColor(Color(255, 255, 0));
-                    sound.setBuffer(selectBuffer);
-                    sound.play();
-                    clickedAnotherWaste = true;
-                    break;
-                }
-            }
-            // Se não clicou em outro lixo, tenta jogar na lixeira
-            if (!clickedAnotherWaste) {
-                bool clickedBin = false;
-                WasteType selectedType = activeWastes[selectedWasteIndex].type;
-
-                for (const auto& bin : binBounds) {
-                    if (bin.second.contains(touchPos)) {
-                        clickedBin = true;
-                        bool correct = (bin.first == selectedType);
-
-                        if (correct) {
-                            sound.setBuffer(correctBuffer);
-                            sound.play();
-
-                            int points = 5 + combo;
-                            points = static_cast<int>(points * comboBoostMultiplier);
-                            score += points;
-
-                            combo++;
-                            comboClock.restart();
-                            
-                            // Na fase do boss, acertos recuperam vida
-                            if (inBossFight) {
-                                playerLife = min(100, playerLife + 5);
-                            } else {
-                                reputation = min(100, reputation + 2);
-                            }
-
-                            if (inBossFight) {
-                                correctHitsSinceLastBossPowerUp++;
-                                if (correctHitsSinceLastBossPowerUp >= 5) {
-                                    spawnBossPowerUp();
-                                    correctHitsSinceLastBossPowerUp = 0;
-                                }
-                            }
-                        } else {
-                            if (inBossFight) {
-                                playerLife = max(0, playerLife - 10);
-                            } else {
-                                reputation = max(0, reputation - 10);
-                            }
-                            sound.setBuffer(wrongBuffer);
-                            sound.play();
-                            combo = 0;
-                            if (!inBossFight && reputation <= 0) {
-                                bgMusic.pause();
-                                defeatSound.play();
-                                inDefeatScreen = true;
-                            }
-                        }
-
-                        // Remover apenas o item selecionado
-                        if (selectedWasteIndex >= 0 && selectedWasteIndex < static_cast<int>(activeWastes.size())) {
-                            activeWastes.erase(activeWastes.begin() + selectedWasteIndex);
-                        }
-                        selectedWasteIndex = -1;
-                        break; // Sai do loop das lixeiras
+                break;
+
+            case EVENT_ROLL:
+                // Eventos especiais na fase 3
+                if constexpr (config.specialEvents) {
+                    eventTimer = timers.schedule(TimerWheel::ticksFor(10.0f), EVENT_ROLL);
+                    if (!specialEvent && randomInt(100) < 30) {
+                        startSpecialEvent();
                     }
                 }
-                // Se não clicou em lixeira, apenas desmarca o lixo selecionado e não faz nada
-                if (!clickedBin) {
-                    if (selectedWasteIndex >= 0 && selectedWasteIndex < static_cast<int>(activeWastes.size())) {
-                        activeWastes[selectedWasteIndex].sprite.setColor(Color::White);
+                break;
+
+            case EVENT_END:
+                specialEvent = false;
+                break;
+
+            case COMBO_TIMEOUT:
+                combo = 0;
+                break;
+
+            case TIME_FREEZE_END:
+                timeFreezeFactor = 1.0f;
+                break;
+
+            case COMBO_BOOST_END:
+                comboBoostMultiplier = 1.0f;
+                break;
+
+            case MAGNET_END:
+                // Resíduos já atraídos seguem até a lixeira
+                magnetActive = false;
+                break;
+
+            case POWERUP_EXPIRE:
+                for (auto& powerUp : activePowerUps) {
+                    if (powerUp.id == payload) {
+                        powerUp.active = false;
+                        break;
                     }
-                    selectedWasteIndex = -1;
                 }
+                break;
+
+            case MODIFIER_END:
+                modifiers[payload].active = false;
+                foldModifiers();
+                break;
+        }
+    }
+
+    void startSpecialEvent() {
+        specialEvent = true;
+        timers.schedule(TimerWheel::ticksFor(3.0f), EVENT_END);
+        const SpecialEventDef& event = SPECIAL_EVENTS[randomInt(SPECIAL_EVENT_COUNT)];
+        pushMessage(event.message, Color::Red);
+
+        if (event.seconds > 0.0f) {
+            pushModifier(event.modifiers, event.seconds);
+        }
+        if (event.resetCombo) {
+            combo = 0;
+        }
+    }
+
+    // Ocupa uma vaga livre da pilha; o MODIFIER_END leva o índice dela
+    void pushModifier(const Modifiers& factors, float seconds) {
+        auto slot = find_if(modifiers.begin(), modifiers.end(), [](const TimedModifier& m) { return !m.active; });
+        if (slot == modifiers.end()) {
+            slot = modifiers.insert(slot, TimedModifier());
+        }
+        unsigned index = static_cast<unsigned>(slot - modifiers.begin());
+        slot->factors = factors;
+        slot->active = true;
+        slot->timer = timers.schedule(TimerWheel::ticksFor(seconds), MODIFIER_END, index);
+        foldModifiers();
+    }
+
+    void clearModifiers() {
+        for (auto& modifier : modifiers) {
+            timers.cancel(modifier.timer);
+        }
+        modifiers.clear();
+        foldModifiers();
+    }
+
+    // Só quando a pilha muda
+    void foldModifiers() {
+        stacked = Modifiers();
+        for (const auto& modifier : modifiers) {
+            if (modifier.active) {
+                stacked.apply(modifier.factors);
             }
         }
     }
 
-    void spawnBossPowerUp() {
-        if (phase == BOSS && inBossFight) {
-            activePowerUps.push_back(PowerUp(powerUpTextures[PowerUp::BOSS_DAMAGE], PowerUp::BOSS_DAMAGE));
+    // Os power-ups mudam a cada tick (o congelamento entra e sai aos poucos)
+    void updateEffective() {
+        effective = stacked;
+        effective.speed *= timeFreezeFactor;
+        effective.score *= comboBoostMultiplier;
+    }
+
+    void restartComboTimeout() {
+        restartTimer(comboTimer, params.comboTimeout, COMBO_TIMEOUT);
+    }
+
+    void updatePowerUpEffects() {
+        // Atualizar efeito de congelamento
+        if (timers.pending(timeFreezeTimer)) {
+            float remaining = remainingSeconds(timeFreezeTimer);
+
+            // Transição suave: 0-1 segundos: congelando, 4-5 segundos: descongelando
+            if (remaining > 4.0f) {
+                timeFreezeFactor = max(0.1f, 1.0f - (5.0f - remaining));
+            } else if (remaining < 1.0f) {
+                timeFreezeFactor = min(1.0f, remaining);
+            } else {
+                timeFreezeFactor = 0.1f;
+            }
         }
     }
 
-    void handlePowerUpClick(Vector2f touchPos) {
-        for (size_t i = 0; i < activePowerUps.size(); ++i) {
-            // Verifica se o clique foi no efeito de brilho (maior e mais fácil de clicar)
-            if (activePowerUps[i].glowEffect.getGlobalBounds().contains(touchPos)) {
-                if (activePowerUps[i].type == PowerUp::BOSS_DAMAGE && inBossFight) {
-                    bossLife = max(0, bossLife - 25); // Aumenta o dano ao boss
-                    messageText.setString("Ataque no Boss! -25 HP");
-                    messageText.setFillColor(Color::Red);
-                } else {
-                    usePowerUp(activePowerUps[i].type);
-                }
-                powerUpSound.play();
-                activePowerUps[i].active = false;
-                break;
+    // Aponta o resíduo para o centro da lixeira e agenda sua chegada
+    void scheduleMagnet(Waste& waste) {
+        auto bin = binBounds.find(waste.type);
+        if (waste.magnetized || bin == binBounds.end()) return;
+
+        FloatRect binRect = bin->second;
+        Vector2f target(binRect.left + binRect.width/2, binRect.top + binRect.height/2);
+        Vector2f direction = target - waste.position;
+        float distance = sqrt(direction.x*direction.x + direction.y*direction.y);
+
+        waste.velocity = distance > 0 ? direction / distance * MAGNET_SPEED : Vector2f();
+        waste.magnetized = true;
+        waste.wave = -1;
+        magnetArrivals.push(MagnetArrival{magnetTravel + distance, waste.id});
+    }
+
+    void activateMagnet() {
+        if (!magnetActive && magnetArrivals.empty()) {
+            magnetTravel = 0.0f;
+        }
+        magnetActive = true;
+        restartTimer(magnetTimer, 5.0f, MAGNET_END);
+        for (auto& waste : activeWastes) {
+            if (waste.active && !waste.dragged) {
+                scheduleMagnet(waste);
             }
         }
     }
 
-    // --- Adicione uma função para atualizar o background conforme a fase ---
-    void updateBackground() {
-        if (phase == BOSS) {
-            bgSprite.setTexture(bgBoss, true);
-        } else if (phase == COMMUNITY) {
-            bgSprite.setTexture(bgCommunity, true);
-        } else if (phase == INDUSTRIAL) {
-            bgSprite.setTexture(bgIndustrial, true);
+    // Custo proporcional às chegadas do tick, não ao número de resíduos
+    void updateMagnetArrivals() {
+        if (magnetArrivals.empty()) return;
+        magnetTravel += MAGNET_SPEED * effective.speed;
+
+        while (!magnetArrivals.empty() && magnetArrivals.top().travel <= magnetTravel) {
+            unsigned wasteId = magnetArrivals.top().wasteId;
+            magnetArrivals.pop();
+
+            // O jogador pode ter separado o resíduo antes da chegada
+            auto waste = find_if(activeWastes.begin(), activeWastes.end(),
+                [&](const Waste& w) { return w.id == wasteId && w.active; });
+            if (waste == activeWastes.end()) continue;
+
+            // Coleta automaticamente
+            FloatRect binRect = binBounds[waste->type];
+            Vector2f target(binRect.left + binRect.width/2, binRect.top + binRect.height/2);
+            waste->position = target;
+            int points = static_cast<int>(params.magnetPoints * effective.score);
+            score += points;
+            combo++;
+            restartComboTimeout();
+
+            // Na fase do boss, acertos recuperam vida
+            if (inBossFight) {
+                playerLife = min(100, playerLife + params.playerLifeGain);
+            } else {
+                reputation = min(100, reputation + params.reputationGain);
+            }
+
+            waste->active = false;
+            pushEvent(SimEvent::MAGNET_COLLECTED, target);
+        }
+    }
+
+    // Toque do jogador: primeiro power-ups, depois lixos e lixeiras
+    void handleTap(Vector2f touchPos) {
+        if (phaseComplete || defeated) return;
+        handlePowerUpClick(touchPos);
+        handleClick(touchPos);
+    }
+
+    void selectWaste(int index) {
+        // Remove destaque do anterior
+        if (selectedWasteIndex >= 0 && selectedWasteIndex < static_cast<int>(activeWastes.size())) {
+            activeWastes[selectedWasteIndex].selected = false;
+        }
+        selectedWasteIndex = index;
+        activeWastes[index].selected = true;
+        pushEvent(SimEvent::WASTE_SELECTED, activeWastes[index].position);
+    }
+
+    void handleClick(Vector2f touchPos) {
+        // Verifica se tocou em um lixo (seleciona ou troca a seleção)
+        for (size_t i = 0; i < activeWastes.size(); ++i) {
+            if (wasteBounds(activeWastes[i]).contains(touchPos)) {
+                selectWaste(static_cast<int>(i));
+                return;
+            }
+        }
+
+        // Se nenhum lixo está selecionado, não há o que jogar na lixeira
+        if (selectedWasteIndex == -1) {
+            return;
+        }
+
+        // Se não clicou em outro lixo, tenta jogar na lixeira
+        for (const auto& bin : binBounds) {
+            if (bin.second.contains(touchPos)) {
+                sortSelected(bin.first, bin.second);
+                return;
+            }
+        }
+
+        // Se não clicou em lixeira, apenas desmarca o lixo selecionado
+        activeWastes[selectedWasteIndex].selected = false;
+        selectedWasteIndex = -1;
+    }
+
+    // Joga o resíduo selecionado na lixeira
+    void sortSelected(WasteType binType, const FloatRect& binRect) {
+        Vector2f binCenter(binRect.left + binRect.width / 2, binRect.top + binRect.height / 2);
+        bool correct = (binType == activeWastes[selectedWasteIndex].type);
+
+        if (correct) {
+            int points = params.basePoints + combo;
+            points = static_cast<int>(points * effective.score);
+            score += points;
+
+            combo++;
+            restartComboTimeout();
+
+            // Na fase do boss, acertos recuperam vida
+            if (inBossFight) {
+                playerLife = min(100, playerLife + params.playerLifeGain);
+            } else {
+                reputation = min(100, reputation + params.reputationGain);
+            }
+            pushEvent(SimEvent::CORRECT_SORT, binCenter);
+
+            if (inBossFight) {
+                correctHitsSinceLastBossPowerUp++;
+                if (correctHitsSinceLastBossPowerUp >= params.hitsPerBossPowerUp) {
+                    spawnBossPowerUp();
+                    correctHitsSinceLastBossPowerUp = 0;
+                }
+            }
         } else {
-            bgSprite.setTexture(bgMegacenter, true);
+            if (inBossFight) {
+                playerLife = max(0, playerLife - params.playerLifeWrongPenalty);
+            } else {
+                reputation = max(0, reputation - params.reputationWrongPenalty);
+            }
+            combo = 0;
+            pushEvent(SimEvent::WRONG_SORT, binCenter);
+            if (!inBossFight && reputation <= 0) {
+                setDefeated();
+            }
         }
 
-        // Ajusta o tamanho do background para preencher a janela
-        bgSprite.setScale(
-            static_cast<float>(MOBILE_RESOLUTION_X) / bgSprite.getLocalBounds().width,
-            static_cast<float>(MOBILE_RESOLUTION_Y) / bgSprite.getLocalBounds().height
-        );
+        // Remover apenas o item selecionado
+        activeWastes.erase(activeWastes.begin() + selectedWasteIndex);
+        selectedWasteIndex = -1;
     }
 
-    // --- Modifique checkPhaseTransition para mostrar a tela de transição ---
-    void checkPhaseTransition() {
-        if (phase == COMMUNITY && score >= 60 && !inLevelTransition) {
-            inLevelTransition = true;
-            levelInfoText.setString("Fase 1 completa!\nPontuacao: " + to_string(score) +
-                               "\nReputacao: " + to_string(reputation) + "%");
-            bgMusic.pause();
-            victorySound.play();
-        } else if (phase == INDUSTRIAL && score >= 120 && !inLevelTransition) {
-            inLevelTransition = true;
-            levelInfoText.setString("Fase 2 completa!\nPontuacao: " + to_string(score) +
-                               "\nReputacao: " + to_string(reputation) + "%");
-            bgMusic.pause();
-            victorySound.play();
-        } else if (phase == MEGACENTER && score >= 240 && !inLevelTransition) {
-            inLevelTransition = true;
-            levelInfoText.setString("Boss Fight!\nPrepare-se para o desafio final!");
-            bgMusic.pause();
-            victorySound.play();
+    Waste* findWaste(unsigned wasteId) {
+        for (auto& waste : activeWastes) {
+            if (waste.id == wasteId && waste.active) {
+                return &waste;
+            }
         }
+        return nullptr;
     }
 
-    void renderDefeatScreen() {
-        window.clear(Color(30, 0, 0));
-        // Fundo escuro
-        RectangleShape overlay(Vector2f(MOBILE_RESOLUTION_X, MOBILE_RESOLUTION_Y));
-        overlay.setFillColor(Color(0, 0, 0, 200));
-        window.draw(bgSprite);
-        window.draw(overlay);
-
-        Text defeatText;
-        defeatText.setFont(font);
-        defeatText.setString("Derrota!\nSua reputacao chegou a zero.\nToque para voltar ao menu.");
-        defeatText.setCharacterSize(42);
-        defeatText.setFillColor(Color::Red);
-        defeatText.setStyle(Text::Bold);
-        defeatText.setOrigin(defeatText.getLocalBounds().width / 2, 0);
-        defeatText.setPosition(MOBILE_RESOLUTION_X / 2, MOBILE_RESOLUTION_Y * 0.3f);
-        window.draw(defeatText);
+    void cancelDrag() {
+        if (!dragging) return;
+        dragging = false;
+        if (Waste* waste = findWaste(draggedWasteId)) {
+            waste->dragged = false;
+        }
+    }
 
-        window.display();
+    void pointerDown(Vector2f touchPos) {
+        if (phaseComplete || defeated) return;
+        cancelDrag(); // Segundo dedo: o arraste anterior volta a cair
+        handlePowerUpClick(touchPos);
+
+        // Tocar num resíduo seleciona e começa a arrastar (os atraídos pelo magnet só são selecionados)
+        for (size_t i = 0; i < activeWastes.size(); ++i) {
+            Waste& waste = activeWastes[i];
+            if (wasteBounds(waste).contains(touchPos)) {
+                selectWaste(static_cast<int>(i));
+                if (!waste.magnetized) {
+                    dragging = true;
+                    draggedWasteId = waste.id;
+                    dragOffset = waste.position - touchPos;
+                    dragStart = touchPos;
+                    dragMoved = false;
+                    waste.dragged = true;
+                    waste.wave = -1; // Solto, cai em linha reta
+                }
+                return;
+            }
+        }
+        handleClick(touchPos);
     }
 
-    // --- Adicione uma função para resetar o jogo ---
-    void resetGame() {
-        score = 0;
-        reputation = 100;
-        phase = 0;
-        combo = 0;
-        spawnTimer = 0;
-        gameTimer = 0;
-        eventTimer = 0;
-        powerUpSpawnTimer = 0;
-        specialEvent = false;
+    void pointerMove(Vector2f touchPos) {
+        if (!dragging) return;
+        Waste* waste = findWaste(draggedWasteId);
+        if (waste == nullptr) {
+            dragging = false;
+            return;
+        }
+        Vector2f moved = touchPos - dragStart;
+        if (!dragMoved && sqrt(moved.x * moved.x + moved.y * moved.y) > TOUCH_THRESHOLD) {
+            dragMoved = true;
+        }
+        waste->position = touchPos + dragOffset;
+    }
+
+    void pointerUp(Vector2f touchPos) {
+        if (!dragging) return;
+        pointerMove(touchPos);
+        dragging = false;
+        Waste* waste = findWaste(draggedWasteId);
+        if (waste == nullptr) return;
+        waste->dragged = false;
+
+        // Toque sem arrastar: continua selecionado para o toque na lixeira
+        if (!dragMoved || phaseComplete || defeated) return;
+
+        for (const auto& bin : binBounds) {
+            if (bin.second.contains(touchPos)) {
+                // A seleção pode ter mudado por outro toque durante o arraste
+                if (selectedWasteIndex >= 0) {
+                    activeWastes[selectedWasteIndex].selected = false;
+                }
+                selectedWasteIndex = static_cast<int>(waste - activeWastes.data());
+                waste->selected = true;
+                sortSelected(bin.first, bin.second);
+                return;
+            }
+        }
+
+        // Solto fora das lixeiras: volta a cair de onde parou
+        waste->selected = false;
         selectedWasteIndex = -1;
-        activeWastes.clear();
-        activePowerUps.clear();
-        inventory.clear();
-        inLevelTransition = false;
-        inDefeatScreen = false;
-        inBossIntro = false;
-        timeFreezeFactor = 1.0f;
-        timeFreezeDuration = 0.0f;
-        shieldCount = 0;
-        comboBoostMultiplier = 1.0f;
-        comboBoostDuration = 0.0f;
-        magnetActive = false;
-        magnetDuration = 0.0f;
-        inBossFight = false;
-        playerLife = 100;
-        bossLife = 100;
-        correctHitsSinceLastBossPowerUp = 0;
-        setupBins();
-        updateBackground();
+        if (magnetActive) {
+            scheduleMagnet(*waste);
+        }
     }
 
-    void renderPowerUps() {
-        for (const auto& powerUp : activePowerUps) {
-            window.draw(powerUp.glowEffect);
-            window.draw(powerUp.sprite);
+    void handlePowerUpClick(Vector2f touchPos) {
+        for (auto& powerUp : activePowerUps) {
+            if (powerUp.active && powerUp.bounds().contains(touchPos)) {
+                if (powerUp.type == PowerUp::BOSS_DAMAGE && inBossFight) {
+                    bossLife = max(0, bossLife - params.bossDamage); // Aumenta o dano ao boss
+                    pushMessage(MSG_BOSS_ATTACK, Color::Red, params.bossDamage);
+                    pushEvent(SimEvent::BOSS_HIT, powerUp.position);
+                    scripts.signal(SIGNAL_BOSS_HIT);
+                } else {
+                    usePowerUp(powerUp.type);
+                    pushEvent(SimEvent::POWERUP_USED, powerUp.position);
+                }
+                powerUp.active = false;
+                timers.cancel(powerUp.expireTimer);
+                break;
+            }
         }
     }
 
@@ -1208,503 +1964,5984 @@ public:
         switch (type) {
             case PowerUp::COMBO_BOOST:
                 comboBoostMultiplier = 3.0f;
-                comboBoostDuration = 10.0f;
-                messageText.setString("Combo Boost Ativado! Pontos triplicados!");
-                messageText.setFillColor(Color::Yellow);
+                restartTimer(comboBoostTimer, 10.0f, COMBO_BOOST_END);
+                pushMessage(MSG_COMBO_BOOST, Color::Yellow);
                 break;
 
             case PowerUp::TIME_FREEZE:
-                timeFreezeDuration = 5.0f;
-                messageText.setString("Time Freeze Ativado! Velocidade reduzida!");
-                messageText.setFillColor(Color::Cyan);
+                restartTimer(timeFreezeTimer, 5.0f, TIME_FREEZE_END);
+                pushMessage(MSG_TIME_FREEZE, Color::Cyan);
                 break;
 
             case PowerUp::MAGNET:
-                magnetActive = true;
-                magnetDuration = 5.0f;
-                messageText.setString("Magnet Ativado! Residuos sendo atraidos!");
-                messageText.setFillColor(Color::Green);
+                activateMagnet();
+                pushMessage(MSG_MAGNET, Color::Green);
                 break;
 
             case PowerUp::SHIELD:
                 shieldCount += 3;
-                messageText.setString("Shield Ativado! +3 escudos de protecao!");
-                messageText.setFillColor(Color::Blue);
+                pushMessage(MSG_SHIELD, Color::Blue);
+                break;
+
+            default:
                 break;
         }
-        messageText.setStyle(Text::Bold);
-        messageText.setOrigin(messageText.getLocalBounds().width / 2, 0);
-        messageText.setPosition(MOBILE_RESOLUTION_X / 2, powerUpTextY);
-        powerUpTextTimer = 0.0f;
-        powerUpTextAlpha = 255.0f;
-        powerUpTextY = MOBILE_RESOLUTION_Y / 2;
-        comboClock.restart();
+        restartComboTimeout();
     }
 
-    void renderActivePowerUpEffects() {
-        float x = MOBILE_RESOLUTION_X * 0.8f;
-        float y = 150;
-        float spacing = 60;
+    // Chamado ao confirmar a tela de transição
+    void advancePhase() {
+        phaseComplete = false;
+        activeWastes.clear();
+        waves.clear();
+        combo = 0;
+        selectedWasteIndex = -1;
+        dragging = false;
+        magnetArrivals = decltype(magnetArrivals)();
+        clearModifiers(); // Eventos do megacentro não seguem para o boss
+        if (phase < BOSS) {
+            phase++;
+            setupBins();
+        }
+        startPhase();
+    }
 
-        // Time Freeze
-        if (timeFreezeDuration > 0) {
-            Sprite icon;
-            icon.setTexture(powerUpTextures[PowerUp::TIME_FREEZE]);
-            icon.setScale(0.08f, 0.08f);
-            icon.setPosition(x, y);
-            window.draw(icon);
-
-            // Barra de tempo
-            RectangleShape barBack(Vector2f(60, 8));
-            barBack.setFillColor(Color(50,50,50));
-            barBack.setPosition(x + 70, y + 30);
-            window.draw(barBack);
-
-            float ratio = timeFreezeDuration / 5.0f;
-            RectangleShape bar(Vector2f(60 * ratio, 8));
-            bar.setFillColor(Color::Cyan);
-            bar.setPosition(x + 70, y + 30);
-            window.draw(bar);
-            
-            y += spacing;
+    void startBossFight() {
+        inBossFight = true;
+        scripts.start(bossScript());
+    }
+
+    // --- Ataques do boss ---
+    // Rajadas de baterias até a vida cair abaixo de bossRageLife; dali em
+    // diante, chuva tóxica sem pausa. Tudo somado ao spawn normal da fase.
+    Script bossScript() {
+        ScriptRunner::Id attack = scripts.start(batteryBursts());
+        co_await scripts.waitUntil(SIGNAL_BOSS_HIT, [this] {
+            return bossLife < params.bossRageLife;
+        });
+        scripts.stop(attack);
+        pushMessage(MSG_BOSS_RAGE, Color::Red);
+        co_await toxicRain();
+    }
+
+    Script batteryBursts() {
+        for (int i = 0;; ++i) {
+            co_await scripts.delay(params.bossBurstPeriod);
+            pushMessage(MSG_BOSS_BURST, Color(255, 140, 0));
+            co_await burst(BATTERY, params.bossBurstSize, params.bossBurstDuration, static_cast<PathShape>(i % PATH_SHAPE_COUNT));
         }
+    }
 
-        // Combo Boost
-        if (comboBoostDuration > 0) {
-            Sprite icon;
-            icon.setTexture(powerUpTextures[PowerUp::COMBO_BOOST]);
-            icon.setScale(0.08f, 0.08f);
-            icon.setPosition(x, y);
-            window.draw(icon);
-
-            // Barra de tempo
-            RectangleShape barBack(Vector2f(60, 8));
-            barBack.setFillColor(Color(50,50,50));
-            barBack.setPosition(x + 70, y + 30);
-            window.draw(barBack);
-
-            float ratio = comboBoostDuration / 10.0f;
-            RectangleShape bar(Vector2f(60 * ratio, 8));
-            bar.setFillColor(Color::Yellow);
-            bar.setPosition(x + 70, y + 30);
-            window.draw(bar);
-            
-            // Multiplicador
-            Text multText;
-            multText.setFont(font);
-            multText.setString("x" + to_string(static_cast<int>(comboBoostMultiplier)));
-            multText.setCharacterSize(30);
-            multText.setFillColor(Color::Yellow);
-            multText.setPosition(x + 140, y);
-            window.draw(multText);
-            
-            y += spacing;
+    // count ondas de um tipo espalhadas ao longo de seconds, todas na mesma forma de curva
+    Script burst(WasteType type, int count, float seconds, PathShape shape) {
+        Uint64 gap = TimerWheel::ticksFor(seconds / max(1, count));
+        for (int i = 0; i < count; ++i) {
+            spawnWave<BOSS>(type, params.bossWaveSize, shape);
+            co_await scripts.delayTicks(gap);
         }
+    }
 
-        // Magnet
-        if (magnetActive) {
-            Sprite icon;
-            icon.setTexture(powerUpTextures[PowerUp::MAGNET]);
-            icon.setScale(0.08f, 0.08f);
-            icon.setPosition(x, y);
-            window.draw(icon);
-
-            // Barra de tempo
-            RectangleShape barBack(Vector2f(60, 8));
-            barBack.setFillColor(Color(50,50,50));
-            barBack.setPosition(x + 70, y + 30);
-            window.draw(barBack);
-
-            float ratio = magnetDuration / 5.0f;
-            RectangleShape bar(Vector2f(60 * ratio, 8));
-            bar.setFillColor(Color::Green);
-            bar.setPosition(x + 70, y + 30);
-            window.draw(bar);
-            
-            y += spacing;
+    Script toxicRain() {
+        static const WasteType toxic[] = {BATTERY, ELECTRONIC};
+        for (int i = 0;; ++i) {
+            co_await scripts.delay(params.bossRainPeriod);
+            spawnWasteOfType<BOSS>(toxic[i % 2], rng);
         }
+    }
 
-        // Shield
-        if (shieldCount > 0) {
-            Sprite icon;
-            icon.setTexture(powerUpTextures[PowerUp::SHIELD]);
-            icon.setScale(0.08f, 0.08f);
-            icon.setPosition(x, y);
-            window.draw(icon);
+    // Falso na transição de fase, na introdução do boss e depois da derrota:
+    // nessas telas o tempo da partida fica parado até a entrada que as libera
+    bool running() const {
+        return !defeated && !phaseComplete && !(phase == BOSS && !inBossFight);
+    }
+};
 
-            // Contador
-            Text countText;
-            countText.setFont(font);
-            countText.setString(to_string(shieldCount));
-            countText.setCharacterSize(36);
-            countText.setFillColor(Color::Blue);
-            countText.setStyle(Text::Bold);
-            countText.setPosition(x + 60, y - 10);
-            window.draw(countText);
+// --- Resolução dinâmica ---
+// O jogo desenha numa textura offscreen do tamanho lógico (720x1280), mas só
+// na fração "scale" dela; essa região é esticada para a janela. Em GPUs
+// fracas o preenchimento do fundo e das sobreposições é o gargalo, então a
+// escala cai quando o frame estoura o orçamento e volta quando sobra tempo.
+#define RESOLUTION_SCALE_MIN 0.5f
+#define RESOLUTION_SCALE_STEP 0.1f
+#define RESOLUTION_COOLDOWN_FRAMES 30
+
+class DynamicResolution {
+public:
+    float scale = 1.0f;
+    float frameAverage = SIM_DT; // Intervalo entre frames (inclui espera da GPU)
+    float workAverage = 0.0f;    // Tempo de CPU para montar o frame
+    int cooldown = 0;
+
+    // Média móvel dos tempos medidos; devolve true se a escala mudou
+    bool update(float frameSeconds, float workSeconds, float budget) {
+        frameAverage += (frameSeconds - frameAverage) * 0.1f;
+        workAverage += (workSeconds - workAverage) * 0.1f;
+        if (cooldown > 0) {
+            cooldown--;
+            return false;
         }
-    }
 
-    void renderLifeBars() {
-        if (inBossFight) {
-            // Atualiza tamanho das barras
-            playerLifeBar.setSize(Vector2f(MOBILE_RESOLUTION_X * 0.8f * playerLife / 100.0f, 30));
-            bossLifeBar.setSize(Vector2f(MOBILE_RESOLUTION_X * 0.8f * bossLife / 100.0f, 30));
-            
-            // Desenha fundos
-            window.draw(playerLifeBarBack);
-            window.draw(bossLifeBarBack);
-            
-            // Desenha barras de vida
-            window.draw(bossLifeBar);
-            window.draw(playerLifeBar);
-            
-            // Desenha retratos ao lado das barras
-            bossPortrait.setPosition(30, 40);
-            window.draw(bossPortrait);
-            
-            playerPortrait.setPosition(30, MOBILE_RESOLUTION_Y * 0.9f - 15);
-            window.draw(playerPortrait);
-            
-            // Desenha textos de vida
-            Text bossLifeText;
-            bossLifeText.setFont(font);
-            bossLifeText.setString(to_string(bossLife) + "%");
-            bossLifeText.setCharacterSize(30);
-            bossLifeText.setFillColor(Color::White);
-            bossLifeText.setStyle(Text::Bold);
-            bossLifeText.setPosition(MOBILE_RESOLUTION_X - 100, 55);
-            window.draw(bossLifeText);
-            
-            Text playerLifeText;
-            playerLifeText.setFont(font);
-            playerLifeText.setString(to_string(playerLife) + "%");
-            playerLifeText.setCharacterSize(30);
-            playerLifeText.setFillColor(Color::White);
-            playerLifeText.setStyle(Text::Bold);
-            playerLifeText.setPosition(MOBILE_RESOLUTION_X - 100, MOBILE_RESOLUTION_Y * 0.9f);
-            window.draw(playerLifeText);
+        float previous = scale;
+        if (frameAverage > budget * 1.1f) {
+            scale = max(RESOLUTION_SCALE_MIN, scale - RESOLUTION_SCALE_STEP);
+        } else if (frameAverage < budget * 1.02f && workAverage < budget * 0.6f) {
+            scale = min(1.0f, scale + RESOLUTION_SCALE_STEP);
+        }
+        if (scale == previous) {
+            return false;
         }
+        cooldown = RESOLUTION_COOLDOWN_FRAMES;
+        return true;
     }
 
-    void run() {
-        while (window.isOpen()) {
-            Event event;
-            while (window.pollEvent(event)) {
-                if (event.type == Event::Closed) {
-                    window.close();
-                }
-                
-                // Controle de som na tela inicial
-                if (inStartScreen) {
-                    if (event.type == Event::TouchBegan) {
-                        Vector2f touchPos(event.touch.x, event.touch.y);
-                        if (soundIcon.getGlobalBounds().contains(touchPos)) {
-                            soundMuted = !soundMuted;
-                            if (soundMuted) {
-                                bgMusic.setVolume(0);
-                                sound.setVolume(0);
-                                victorySound.setVolume(0);
-                                defeatSound.setVolume(0);
-                                powerUpSound.setVolume(0);
-                                soundIcon.setTexture(soundOffTex);
-                            } else {
-                                bgMusic.setVolume(70);
-                                sound.setVolume(100);
-                                victorySound.setVolume(100);
-                                defeatSound.setVolume(100);
-                                powerUpSound.setVolume(100);
-                                soundIcon.setTexture(soundOnTex);
-                            }
-                        }
-                        // Controle de volume
-                        else if (volumeBar.getGlobalBounds().contains(touchPos)) {
-                            float volumePercent = (touchPos.x - volumeBar.getPosition().x) / volumeBar.getSize().x * 100.0f;
-                            volumePercent = max(0.0f, min(100.0f, volumePercent));
-                            volumeFill.setSize(Vector2f(volumePercent * volumeBar.getSize().x / 100.0f, 15));
-                            bgMusic.setVolume(volumePercent);
-                            volumeDragging = true;
-                        }
-                        else if (startButton.getGlobalBounds().contains(touchPos)) {
-                            inStartScreen = false;
-                            resetGame();
-                            bgMusic.play();
-                        }
-                    }
-                    else if (event.type == Event::TouchMoved && volumeDragging) {
-                        Vector2f touchPos(event.touch.x, event.touch.y);
-                        float volumePercent = (touchPos.x - volumeBar.getPosition().x) / volumeBar.getSize().x * 100.0f;
-                        volumePercent = max(0.0f, min(100.0f, volumePercent));
-                        volumeFill.setSize(Vector2f(volumePercent * volumeBar.getSize().x / 100.0f, 15));
-                        bgMusic.setVolume(volumePercent);
-                    }
-                    else if (event.type == Event::TouchEnded) {
-                        volumeDragging = false;
-                    }
-                }
+    // Tamanho em pixels da região usada, arredondado como o viewport do SFML
+    Vector2i pixelSize() const {
+        return Vector2i(static_cast<int>(0.5f + MOBILE_RESOLUTION_X * scale),
+                        static_cast<int>(0.5f + MOBILE_RESOLUTION_Y * scale));
+    }
 
-                
-                if (inIntroStory && event.type == Event::TouchBegan) {
-                    inIntroStory = false;
-                }
-                
-                // Tela de introdução do boss
-                if (inBossIntro && event.type == Event::TouchBegan) {
-                    inBossIntro = false;
-                    inBossFight = true;
-                }
-                
-                // --- Evento para continuar na tela de transição ---
-                if (inLevelTransition && event.type == Event::TouchBegan) {
-                    Vector2f touchPos(event.touch.x, event.touch.y);
-                    if (continueButton.getGlobalBounds().contains(touchPos)) {
-                        inLevelTransition = false;
-                        activeWastes.clear();
-                        combo = 0;
-                        selectedWasteIndex = -1;
-                        if (phase == COMMUNITY) {
-                            phase = INDUSTRIAL;
-                            setupBins();
-                            updateBackground();
-                            bgMusic.play();
-                        } else if (phase == INDUSTRIAL) {
-                            phase = MEGACENTER;
-                            setupBins();
-                            updateBackground();
-                            bgMusic.play();
-                        } else if (phase == MEGACENTER) {
-                            phase = BOSS;
-                            setupBins();
-                            updateBackground();
-                            inBossIntro = true; // Mostra introdução antes do boss
-                            bgMusic.play();
-                        } else if (phase == BOSS) {
-                            inStartScreen = true;
-                            resetGame();
-                            bgMusic.play();
-                        }
-                    }
-                }
-                // --- Evento para derrota: toque para voltar ao menu ---
-                if (inDefeatScreen && event.type == Event::TouchBegan) {
-                    inDefeatScreen = false;
-                    inStartScreen = true;
-                    resetGame();
-                    bgMusic.play();
-                }
-                if (!inStartScreen && !inLevelTransition && !inDefeatScreen && 
-                    !inIntroStory && !inBossIntro && event.type == Event::TouchBegan) {
-                    Vector2f touchPos(event.touch.x, event.touch.y);
+    View view() const {
+        View logical(FloatRect(0, 0, MOBILE_RESOLUTION_X, MOBILE_RESOLUTION_Y));
+        logical.setViewport(FloatRect(0, 0, scale, scale));
+        return logical;
+    }
+};
 
-                    // Primeiro verifica power-ups
-                    handlePowerUpClick(touchPos);
+// --- Backends de renderização ---
+// Todo desenho do jogo passa por RenderBackend. O backend SFML repassa os
+// drawables para a textura da janela; os outros recebem os mesmos objetos
+// já decompostos em vértices: o nulo só conta o trabalho e o de software
+// rasteriza em CPU num buffer RGBA, sem precisar de GPU.
+// Quads dos glifos com o mesmo layout do sf::Text: linha de base a size do
+// topo, kerning entre pares e getLineSpacing a cada '\n'
+void layoutText(const Font& font, const String& text, unsigned size, bool bold,
+                const Transform& transform, Color color, vector<Vertex>& out) {
+    float x = 0, y = static_cast<float>(size);
+    Uint32 previous = 0;
+    for (Uint32 c : text) {
+        x += font.getKerning(previous, c, size);
+        previous = c;
+        if (c == '\n') {
+            x = 0;
+            y += font.getLineSpacing(size);
+            continue;
+        }
+        const Glyph& glyph = font.getGlyph(c, size, bold);
+        FloatRect b = glyph.bounds;
+        IntRect t = glyph.textureRect;
+        if (b.width > 0 && b.height > 0) {
+            float u0 = t.left, v0 = t.top, u1 = t.left + t.width, v1 = t.top + t.height;
+            out.push_back(Vertex(transform.transformPoint(Vector2f(x + b.left, y + b.top)), color, Vector2f(u0, v0)));
+            out.push_back(Vertex(transform.transformPoint(Vector2f(x + b.left + b.width, y + b.top)), color, Vector2f(u1, v0)));
+            out.push_back(Vertex(transform.transformPoint(Vector2f(x + b.left + b.width, y + b.top + b.height)), color, Vector2f(u1, v1)));
+            out.push_back(Vertex(transform.transformPoint(Vector2f(x + b.left, y + b.top + b.height)), color, Vector2f(u0, v1)));
+        }
+        x += glyph.advance;
+    }
+}
 
-                    // Depois verifica lixos e lixeiras
-                    handleClick(touchPos);
-                }
-            }
+struct RenderCounters {
+    long drawCalls = 0;
+    long vertices = 0;
+    long skipped = 0; // Primitivas que o backend não sabe desenhar
+};
 
-            window.clear(Color(30, 70, 40));
-
-            if (inStartScreen) {
-                bgSprite.setTexture(bgCommunity, true);
-                bgSprite.setScale(
-                    static_cast<float>(MOBILE_RESOLUTION_X) / bgSprite.getLocalBounds().width,
-                    static_cast<float>(MOBILE_RESOLUTION_Y) / bgSprite.getLocalBounds().height
-                );
-                window.draw(bgSprite);
-
-                RectangleShape overlay(Vector2f(MOBILE_RESOLUTION_X, MOBILE_RESOLUTION_Y));
-                overlay.setFillColor(Color(0, 0, 0, 100));
-                window.draw(overlay);
-
-                window.draw(gameTitle);
-                window.draw(startButton);
-                window.draw(startButtonText);
-                window.draw(soundIcon);
-                
-                // Desenhar barra de volume
-                window.draw(volumeBar);
-                window.draw(volumeFill);
-                
-                // Texto de volume
-                Text volumeText;
-                volumeText.setFont(font);
-                volumeText.setString("Volume");
-                volumeText.setCharacterSize(24);
-                volumeText.setFillColor(Color::White);
-                volumeText.setPosition(50, 10);
-                window.draw(volumeText);
-                
-                window.display();
-                continue;
-            }
+class RenderBackend {
+public:
+    RenderCounters frame; // Zerado a cada beginFrame()
+    RenderCounters total;
+    long frames = 0;
 
-            // --- Tela de introdução da história ---
-            if (inIntroStory) {
-                window.clear(Color(40, 40, 60));
-                
-                // Desenhar fundo temático
-                RectangleShape storyBg(Vector2f(MOBILE_RESOLUTION_X, MOBILE_RESOLUTION_Y));
-                storyBg.setFillColor(Color(30, 50, 70));
-                window.draw(storyBg);
-                
-                // Painel para texto
-                storyPanel.setFillColor(Color(0, 0, 0, 180));
-                window.draw(storyPanel);
-                
-                // Texto da história
-                storyText.setString(
-                    "Bem-vindo ao Gerenciador de Reciclagem!\n\n"
-                    "Voce e o novo coletor de lixo da cidade.\n"
-                    "Nosso planeta esta sendo sufocado por residuos,\n"
-                    "e cabe a voce organizar a coleta seletiva.\n\n"
-                    "Sua missao:\n"
-                    "Classificar corretamente os residuos que estao caindo\n"
-                    "dos caminhoes de coleta antes que poluam a cidade.\n\n"
-                    "Cada acerto aumenta sua reputacao e pontos.\n"
-                    "Erros ou residuos perdidos diminuem sua reputacao.\n\n"
-                    "Toque para comecar sua jornada!"
-                );
-                window.draw(storyText);
-                
-                window.display();
-                continue;
-            }
-            
-            // --- Tela de introdução do boss ---
-            if (inBossIntro) {
-                window.clear(Color(70, 30, 30));
-                
-                // Desenhar fundo temático
-                RectangleShape storyBg(Vector2f(MOBILE_RESOLUTION_X, MOBILE_RESOLUTION_Y));
-                storyBg.setFillColor(Color(60, 30, 40));
-                window.draw(storyBg);
-                
-                // Painel para texto
-                storyPanel.setFillColor(Color(0, 0, 0, 180));
-                window.draw(storyPanel);
-                
-                // Texto da história do boss
-                storyText.setString(
-                    "BOSS FINAL: A INDUSTRIA POLUIDORA\n\n"
-                    "Voce chegou ao desafio final!\n"
-                    "A Industria Poluidora, liderada pelo CEO Ganancioso,\n"
-                    "esta despejando residuos toxicos em massa!\n\n"
-                    "Sua missao agora e pessoal:\n"
-                    "Derrote a Industria Poluidora antes que ela destrua\n"
-                    "todos os seus esforcos de reciclagem!\n\n"
-                    "Diferente das fases anteriores:\n"
-                    "- Cada erro reduz sua barra de vida\n"
-                    "- Acertos recuperam um pouco de vida\n"
-                    "- A cada 5 acertos, aparece um power-up especial\n"
-                    "  que pode causar dano direto ao boss\n\n\n"
-                    "Toque para comecar o combate final!"
-                );
-                window.draw(storyText);
-                
-                // Desenhar retrato do boss
-                bossPortrait.setPosition(MOBILE_RESOLUTION_X - 100, MOBILE_RESOLUTION_Y * 0.6f);
-                bossPortrait.setScale(0.05f, 0.05f);
-                window.draw(bossPortrait);
-                
-                window.display();
-                continue;
-            }
+    virtual ~RenderBackend() {}
 
-            // --- Tela de derrota ---
-            if (inDefeatScreen) {
-                renderDefeatScreen();
-                continue;
-            }
+    virtual void clear(Color color) = 0;
+    virtual void drawVertices(const Vertex* vertices, size_t count, PrimitiveType type, const RenderStates& states) = 0;
 
-            // --- Tela de transição de fase ---
-            if (inLevelTransition) {
-                window.draw(bgSprite);
-                window.draw(levelInfoText);
-                window.draw(continueButton);
-                window.draw(continueButtonText);
-                window.display();
+    // Mostra o frame pronto na janela (no modo sem janela não é chamado)
+    virtual void present(RenderTarget& window) {
+        (void)window;
+    }
+
+    // Conteúdo de uma textura mudou (ex.: camada estática recomposta)
+    virtual void textureChanged(const Texture* texture) {
+        (void)texture;
+    }
+
+    void beginFrame() {
+        frames++;
+        frame = RenderCounters();
+    }
+
+    void draw(const Sprite& sprite) { count(4); drawSprite(sprite); }
+    void draw(const Shape& shape) { count(shape.getPointCount()); drawShape(shape); }
+    void draw(const Text& text) { count(text.getString().getSize() * 4); drawText(text); }
+    void draw(const Vertex* vertices, size_t n, PrimitiveType type, const RenderStates& states = RenderStates::Default) {
+        count(n);
+        drawVertices(vertices, n, type, states);
+    }
+
+protected:
+    vector<Vertex> scratch; // Reaproveitado: decompor não aloca depois do primeiro frame
+
+    void count(size_t vertices) {
+        frame.drawCalls++;
+        frame.vertices += vertices;
+        total.drawCalls++;
+        total.vertices += vertices;
+    }
+
+    virtual void drawSprite(const Sprite& sprite) {
+        IntRect rect = sprite.getTextureRect();
+        float w = static_cast<float>(abs(rect.width)), h = static_cast<float>(abs(rect.height));
+        float u0 = rect.left, v0 = rect.top;
+        float u1 = u0 + rect.width, v1 = v0 + rect.height;
+        const Transform& transform = sprite.getTransform();
+        Color color = sprite.getColor();
+
+        scratch.clear();
+        scratch.push_back(Vertex(transform.transformPoint(Vector2f(0, 0)), color, Vector2f(u0, v0)));
+        scratch.push_back(Vertex(transform.transformPoint(Vector2f(w, 0)), color, Vector2f(u1, v0)));
+        scratch.push_back(Vertex(transform.transformPoint(Vector2f(w, h)), color, Vector2f(u1, v1)));
+        scratch.push_back(Vertex(transform.transformPoint(Vector2f(0, h)), color, Vector2f(u0, v1)));
+        drawVertices(scratch.data(), 4, Quads, RenderStates(sprite.getTexture()));
+    }
+
+    // Preenchimento em leque (as formas do SFML são convexas) e contorno
+    // como um quad por aresta, estendido nas pontas para fechar os cantos
+    virtual void drawShape(const Shape& shape) {
+        size_t n = shape.getPointCount();
+        if (n < 3) return;
+        const Transform& transform = shape.getTransform();
+
+        Vector2f centroid;
+        for (size_t i = 0; i < n; ++i) {
+            centroid += shape.getPoint(i);
+        }
+        centroid /= static_cast<float>(n);
+
+        if (shape.getFillColor().a > 0) {
+            scratch.clear();
+            for (size_t i = 0; i < n; ++i) {
+                scratch.push_back(Vertex(transform.transformPoint(shape.getPoint(i)), shape.getFillColor()));
+            }
+            drawVertices(scratch.data(), n, TriangleFan, RenderStates::Default);
+        }
+
+        float thickness = shape.getOutlineThickness();
+        if (thickness != 0 && shape.getOutlineColor().a > 0) {
+            scratch.clear();
+            for (size_t i = 0; i < n; ++i) {
+                Vector2f p0 = shape.getPoint(i), p1 = shape.getPoint((i + 1) % n);
+                Vector2f edge = p1 - p0;
+                float length = sqrt(edge.x * edge.x + edge.y * edge.y);
+                if (length == 0) continue;
+                Vector2f dir = edge / length;
+                Vector2f normal(dir.y, -dir.x);
+                if ((p0.x - centroid.x) * normal.x + (p0.y - centroid.y) * normal.y < 0) {
+                    normal = -normal;
+                }
+                Vector2f a = p0 - dir * fabs(thickness), b = p1 + dir * fabs(thickness);
+                Color color = shape.getOutlineColor();
+                scratch.push_back(Vertex(transform.transformPoint(a), color));
+                scratch.push_back(Vertex(transform.transformPoint(b), color));
+                scratch.push_back(Vertex(transform.transformPoint(b + normal * thickness), color));
+                scratch.push_back(Vertex(transform.transformPoint(a + normal * thickness), color));
+            }
+            drawVertices(scratch.data(), scratch.size(), Quads, RenderStates::Default);
+        }
+    }
+
+    // Refaz o layout a cada chamada; textos fixos do jogo usam TextRun
+    virtual void drawText(const Text& text) {
+        const Font* font = text.getFont();
+        if (font == nullptr) return;
+        unsigned size = text.getCharacterSize();
+        bool bold = (text.getStyle() & Text::Bold) != 0;
+        const Transform& transform = text.getTransform();
+        const Texture& texture = font->getTexture(size);
+
+        scratch.clear();
+        layoutText(*font, text.getString(), size, bold, transform, text.getFillColor(), scratch);
+        drawVertices(scratch.data(), scratch.size(), Quads, RenderStates(&texture));
+    }
+};
+
+// Desenha na textura offscreen do jogo; presente() estica a região usada
+// pela resolução dinâmica até a janela. A exportação troca target a cada
+// quadro para ler um buffer enquanto desenha no outro.
+class SfmlBackend : public RenderBackend {
+public:
+    RenderTexture* target;
+    const DynamicResolution& resolution;
+
+    SfmlBackend(RenderTexture& t, const DynamicResolution& r) : target(&t), resolution(r) {}
+
+    void clear(Color color) override {
+        target->clear(color);
+    }
+
+    void drawVertices(const Vertex* vertices, size_t count, PrimitiveType type, const RenderStates& states) override {
+        target->draw(vertices, count, type, states);
+    }
+
+    void present(RenderTarget& window) override {
+        target->display();
+        Vector2i size = resolution.pixelSize();
+        Sprite frame(target->getTexture(), IntRect(0, 0, size.x, size.y));
+        frame.setScale(static_cast<float>(MOBILE_RESOLUTION_X) / size.x,
+                       static_cast<float>(MOBILE_RESOLUTION_Y) / size.y);
+        window.draw(frame);
+    }
+
+protected:
+    void drawSprite(const Sprite& sprite) override { target->draw(sprite); }
+    void drawShape(const Shape& shape) override { target->draw(shape); }
+    void drawText(const Text& text) override { target->draw(text); }
+};
+
+// Só conta chamadas e vértices: mede o custo do código de desenho do jogo
+class NullBackend : public RenderBackend {
+public:
+    void clear(Color) override {}
+    void drawVertices(const Vertex*, size_t, PrimitiveType, const RenderStates&) override {}
+};
+
+// Rasterizador em CPU: triângulos com cor e coordenadas de textura
+// interpoladas, amostragem do texel mais próximo e mistura alfa
+class SoftwareBackend : public RenderBackend {
+public:
+    unsigned width, height;
+    vector<Uint8> pixels; // RGBA
+    Texture frameTexture;  // Só para mostrar o resultado na janela
+
+    SoftwareBackend(unsigned w = MOBILE_RESOLUTION_X, unsigned h = MOBILE_RESOLUTION_Y)
+        : width(w), height(h), pixels(w * h * 4, 0) {}
+
+    void textureChanged(const Texture* texture) override {
+        images.erase(texture);
+    }
+
+    // Texturas vistas sem janela/GPU precisam ser registradas antes
+    void registerImage(const Texture* texture, const Image& image) {
+        images[texture] = image;
+    }
+
+    void clear(Color color) override {
+        for (size_t i = 0; i < pixels.size(); i += 4) {
+            pixels[i] = color.r;
+            pixels[i + 1] = color.g;
+            pixels[i + 2] = color.b;
+            pixels[i + 3] = color.a;
+        }
+    }
+
+    void drawVertices(const Vertex* vertices, size_t count, PrimitiveType type, const RenderStates& states) override {
+        const Image* image = states.texture ? imageFor(states.texture) : nullptr;
+        if (states.texture && image == nullptr) {
+            frame.skipped++;
+            total.skipped++;
+            return;
+        }
+        auto tri = [&](size_t a, size_t b, size_t c) {
+            rasterize(vertices[a], vertices[b], vertices[c], states.transform, image);
+        };
+        switch (type) {
+            case Triangles:
+                for (size_t i = 0; i + 2 < count; i += 3) tri(i, i + 1, i + 2);
+                break;
+            case TriangleStrip:
+                for (size_t i = 2; i < count; ++i) tri(i - 2, i - 1, i);
+                break;
+            case TriangleFan:
+                for (size_t i = 2; i < count; ++i) tri(0, i - 1, i);
+                break;
+            case Quads:
+                for (size_t i = 0; i + 3 < count; i += 4) {
+                    tri(i, i + 1, i + 2);
+                    tri(i, i + 2, i + 3);
+                }
+                break;
+            default:
+                frame.skipped++;
+                total.skipped++;
+                break;
+        }
+    }
+
+    void present(RenderTarget& window) override {
+        if (frameTexture.getSize() != Vector2u(width, height) && !frameTexture.create(width, height)) {
+            return;
+        }
+        frameTexture.update(pixels.data());
+        Sprite frame(frameTexture);
+        frame.setScale(static_cast<float>(MOBILE_RESOLUTION_X) / width, static_cast<float>(MOBILE_RESOLUTION_Y) / height);
+        window.draw(frame);
+    }
+
+    Image snapshot() const {
+        Image image;
+        image.create(width, height, pixels.data());
+        return image;
+    }
+
+    // FNV-1a dos pixels: compara frames entre execuções
+    Uint64 checksum() const {
+        Uint64 hash = 1469598103934665603ull;
+        for (Uint8 byte : pixels) {
+            hash = (hash ^ byte) * 1099511628211ull;
+        }
+        return hash;
+    }
+
+private:
+    map<const Texture*, Image> images;
+
+    // Cópia da textura da GPU, refeita se ela mudar de tamanho (páginas de fonte crescem)
+    const Image* imageFor(const Texture* texture) {
+        auto found = images.find(texture);
+        if (found != images.end() && found->second.getSize() == texture->getSize()) {
+            return &found->second;
+        }
+        if (texture->getSize().x == 0) {
+            return nullptr;
+        }
+        images[texture] = texture->copyToImage();
+        return &images[texture];
+    }
+
+    void rasterize(const Vertex& va, const Vertex& vb, const Vertex& vc, const Transform& transform, const Image* image) {
+        float sx = static_cast<float>(width) / MOBILE_RESOLUTION_X;
+        float sy = static_cast<float>(height) / MOBILE_RESOLUTION_Y;
+        Vector2f p[3] = { transform.transformPoint(va.position), transform.transformPoint(vb.position),
+                          transform.transformPoint(vc.position) };
+        for (auto& point : p) {
+            point.x *= sx;
+            point.y *= sy;
+        }
+        float area = (p[1].x - p[0].x) * (p[2].y - p[0].y) - (p[1].y - p[0].y) * (p[2].x - p[0].x);
+        if (area == 0) return;
+
+        int minX = max(0, static_cast<int>(floor(min({p[0].x, p[1].x, p[2].x}))));
+        int maxX = min(static_cast<int>(width) - 1, static_cast<int>(ceil(max({p[0].x, p[1].x, p[2].x}))));
+        int minY = max(0, static_cast<int>(floor(min({p[0].y, p[1].y, p[2].y}))));
+        int maxY = min(static_cast<int>(height) - 1, static_cast<int>(ceil(max({p[0].y, p[1].y, p[2].y}))));
+
+        const Vertex* v[3] = { &va, &vb, &vc };
+        const Uint8* texels = image ? image->getPixelsPtr() : nullptr;
+        int texWidth = image ? static_cast<int>(image->getSize().x) : 0;
+        int texHeight = image ? static_cast<int>(image->getSize().y) : 0;
+
+        for (int y = minY; y <= maxY; ++y) {
+            for (int x = minX; x <= maxX; ++x) {
+                float px = x + 0.5f, py = y + 0.5f;
+                // Coordenadas baricêntricas (a área com sinal cobre as duas orientações)
+                float w0 = ((p[1].x - px) * (p[2].y - py) - (p[1].y - py) * (p[2].x - px)) / area;
+                float w1 = ((p[2].x - px) * (p[0].y - py) - (p[2].y - py) * (p[0].x - px)) / area;
+                float w2 = 1.0f - w0 - w1;
+                if (w0 < 0 || w1 < 0 || w2 < 0) continue;
+
+                float r = w0 * v[0]->color.r + w1 * v[1]->color.r + w2 * v[2]->color.r;
+                float g = w0 * v[0]->color.g + w1 * v[1]->color.g + w2 * v[2]->color.g;
+                float b = w0 * v[0]->color.b + w1 * v[1]->color.b + w2 * v[2]->color.b;
+                float a = w0 * v[0]->color.a + w1 * v[1]->color.a + w2 * v[2]->color.a;
+                if (texels) {
+                    int u = static_cast<int>(w0 * v[0]->texCoords.x + w1 * v[1]->texCoords.x + w2 * v[2]->texCoords.x);
+                    int t = static_cast<int>(w0 * v[0]->texCoords.y + w1 * v[1]->texCoords.y + w2 * v[2]->texCoords.y);
+                    u = min(max(u, 0), texWidth - 1);
+                    t = min(max(t, 0), texHeight - 1);
+                    const Uint8* texel = texels + (t * texWidth + u) * 4;
+                    r *= texel[0] / 255.0f;
+                    g *= texel[1] / 255.0f;
+                    b *= texel[2] / 255.0f;
+                    a *= texel[3] / 255.0f;
+                }
+
+                float alpha = a / 255.0f;
+                Uint8* dst = &pixels[(y * width + x) * 4];
+                dst[0] = static_cast<Uint8>(r * alpha + dst[0] * (1 - alpha));
+                dst[1] = static_cast<Uint8>(g * alpha + dst[1] * (1 - alpha));
+                dst[2] = static_cast<Uint8>(b * alpha + dst[2] * (1 - alpha));
+                dst[3] = static_cast<Uint8>(a + dst[3] * (1 - alpha));
+            }
+        }
+    }
+};
+
+// "sfml", "null" ou "cpu"; nullptr se o nome não existir
+unique_ptr<RenderBackend> makeRenderBackend(const string& name, RenderTexture& canvas, const DynamicResolution& resolution) {
+    if (name == "sfml") return unique_ptr<RenderBackend>(new SfmlBackend(canvas, resolution));
+    if (name == "null") return unique_ptr<RenderBackend>(new NullBackend());
+    if (name == "cpu") return unique_ptr<RenderBackend>(new SoftwareBackend());
+    return nullptr;
+}
+
+// --- Partículas de feedback ---
+// Buffer de capacidade fixa em estrutura de arrays (SoA): cada atributo fica
+// num vetor contíguo próprio, então o laço de integração percorre floats em
+// sequência e o compilador consegue vetorizá-lo. Nada é alocado depois do
+// construtor; partículas mortas são trocadas pela última viva.
+#define PARTICLE_CAPACITY 50000
+#define PARTICLE_GRAVITY 0.15f
+
+class ParticleSystem {
+public:
+    size_t count = 0;
+    vector<float> x, y, vx, vy;
+    vector<float> life;    // Ticks restantes
+    vector<float> invLife; // 1 / duração total, para o fade
+    vector<float> size;
+    vector<Color> color;
+    vector<float> opacity;   // Alfa do emit, em float para o laço do fade
+    vector<Uint8> alpha;     // Alfa já com o fade, calculado no update
+    vector<Vertex> vertices; // 4 por partícula, desenhados num único draw
+    minstd_rand rng;
+
+    ParticleSystem() : rng(1) {
+        x.resize(PARTICLE_CAPACITY);
+        y.resize(PARTICLE_CAPACITY);
+        vx.resize(PARTICLE_CAPACITY);
+        vy.resize(PARTICLE_CAPACITY);
+        life.resize(PARTICLE_CAPACITY);
+        invLife.resize(PARTICLE_CAPACITY);
+        size.resize(PARTICLE_CAPACITY);
+        color.resize(PARTICLE_CAPACITY);
+        opacity.resize(PARTICLE_CAPACITY);
+        alpha.resize(PARTICLE_CAPACITY);
+        vertices.resize(PARTICLE_CAPACITY * 4);
+    }
+
+    float randomFloat(float min, float max) {
+        return uniform_real_distribution<float>(min, max)(rng);
+    }
+
+    // Explosão radial; o que não couber no buffer é descartado
+    void emit(Vector2f position, int amount, Color tint, float speed, float seconds, float particleSize = 4.0f) {
+        for (int i = 0; i < amount && count < PARTICLE_CAPACITY; ++i) {
+            float angle = randomFloat(0.0f, 6.2831853f);
+            float s = randomFloat(0.3f, 1.0f) * speed;
+            float ticks = randomFloat(0.6f, 1.0f) * seconds * SIM_TICK_RATE;
+            x[count] = position.x;
+            y[count] = position.y;
+            vx[count] = cos(angle) * s;
+            vy[count] = sin(angle) * s - speed * 0.5f; // Leve impulso para cima
+            life[count] = ticks;
+            invLife[count] = 1.0f / ticks;
+            size[count] = particleSize;
+            color[count] = tint;
+            opacity[count] = tint.a;
+            alpha[count] = tint.a;
+            count++;
+        }
+    }
+
+    // Faíscas dos eventos de um tick; o jogo e os benchmarks usam as mesmas
+    void emit(const vector<SimEvent>& events) {
+        for (const auto& event : events) {
+            switch (event.type) {
+                case SimEvent::CORRECT_SORT:
+                    emit(event.position, 40, Color(100, 250, 100), 5.0f, 0.8f);
+                    break;
+                case SimEvent::MAGNET_COLLECTED:
+                    emit(event.position, 20, Color(120, 255, 180), 3.0f, 0.6f, 3.0f);
+                    break;
+                case SimEvent::WASTE_MISSED:
+                    emit(event.position + Vector2f(25, 0), 30, Color(230, 60, 60), 4.0f, 0.7f);
+                    break;
+                case SimEvent::SHIELD_ABSORBED:
+                    emit(event.position + Vector2f(25, 0), 30, Color(80, 140, 255), 4.0f, 0.7f);
+                    break;
+                case SimEvent::BOSS_HIT:
+                    emit(event.position, 80, Color(255, 200, 60), 7.0f, 1.0f, 5.0f);
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+
+    void update() {
+        const int n = static_cast<int>(count);
+        float* __restrict px = x.data();
+        float* __restrict py = y.data();
+        float* __restrict pvx = vx.data();
+        float* __restrict pvy = vy.data();
+        float* __restrict plife = life.data();
+
+        // Integração sem desvios: um laço só, todos os atributos por partícula
+        for (int i = 0; i < n; ++i) {
+            pvy[i] += PARTICLE_GRAVITY;
+            px[i] += pvx[i];
+            py[i] += pvy[i];
+            plife[i] -= 1.0f;
+        }
+
+        // Remove as mortas trocando pela última viva
+        size_t i = 0;
+        while (i < count) {
+            if (life[i] <= 0.0f) {
+                count--;
+                x[i] = x[count];
+                y[i] = y[count];
+                vx[i] = vx[count];
+                vy[i] = vy[count];
+                life[i] = life[count];
+                invLife[i] = invLife[count];
+                size[i] = size[count];
+                color[i] = color[count];
+                opacity[i] = opacity[count];
+            } else {
+                ++i;
+            }
+        }
+
+        // Fade das vivas num laço à parte, sobre arrays contíguos: o render só copia
+        const int alive = static_cast<int>(count);
+        const float* __restrict pinvLife = invLife.data();
+        const float* __restrict popacity = opacity.data();
+        Uint8* __restrict palpha = alpha.data();
+        for (int i = 0; i < alive; ++i) {
+            float fade = plife[i] * pinvLife[i] * 2.0f; // Some na segunda metade da vida
+            fade = fade < 1.0f ? fade : 1.0f;
+            palpha[i] = static_cast<Uint8>(static_cast<int>(popacity[i] * fade));
+        }
+    }
+
+    void render(RenderBackend& target) {
+        if (count == 0) {
+            return;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            float half = size[i] * 0.5f;
+            Color c = color[i];
+            c.a = alpha[i];
+            Vertex* quad = &vertices[i * 4];
+            quad[0].position = Vector2f(x[i] - half, y[i] - half);
+            quad[1].position = Vector2f(x[i] + half, y[i] - half);
+            quad[2].position = Vector2f(x[i] + half, y[i] + half);
+            quad[3].position = Vector2f(x[i] - half, y[i] + half);
+            quad[0].color = quad[1].color = quad[2].color = quad[3].color = c;
+        }
+        target.draw(vertices.data(), count * 4, Quads);
+    }
+
+    void clear() {
+        count = 0;
+    }
+};
+
+// --- Brilho dos power-ups ---
+// Uma única malha de círculo, desenhada em cada power-up apenas com uma
+// translação. O pulso segue o relógio da simulação (o mesmo para todos) e
+// sai de uma tabela pré-calculada; a malha só é recolorida quando o alfa muda.
+#define GLOW_RADIUS 48.0f
+#define GLOW_SEGMENTS 30
+#define GLOW_PULSE_STEPS 64
+#define GLOW_PULSE_SPEED 5.0f // rad/s
+
+class GlowMesh {
+public:
+    Vertex vertices[GLOW_SEGMENTS + 2]; // Leque: centro + contorno fechado
+    Uint8 pulse[GLOW_PULSE_STEPS];
+    Uint8 alpha = 0;
+
+    GlowMesh() {
+        vertices[0].position = Vector2f(0, 0);
+        for (int i = 0; i <= GLOW_SEGMENTS; ++i) {
+            float angle = i * 6.2831853f / GLOW_SEGMENTS;
+            vertices[i + 1].position = Vector2f(cos(angle) * GLOW_RADIUS, sin(angle) * GLOW_RADIUS);
+        }
+        for (int i = 0; i < GLOW_PULSE_STEPS; ++i) {
+            pulse[i] = static_cast<Uint8>(sin(i * 6.2831853f / GLOW_PULSE_STEPS) * 50 + 150);
+        }
+        setAlpha(pulse[0]);
+    }
+
+    void setAlpha(Uint8 a) {
+        alpha = a;
+        for (auto& vertex : vertices) {
+            vertex.color = Color(255, 255, 255, a);
+        }
+    }
+
+    void setTick(Uint64 tick) {
+        const double stepsPerTick = GLOW_PULSE_STEPS * GLOW_PULSE_SPEED / (6.283185307 * SIM_TICK_RATE);
+        Uint8 a = pulse[static_cast<Uint64>(tick * stepsPerTick) % GLOW_PULSE_STEPS];
+        if (a != alpha) {
+            setAlpha(a);
+        }
+    }
+
+    void draw(RenderBackend& target, Vector2f center) const {
+        Transform transform;
+        transform.translate(center);
+        target.draw(vertices, GLOW_SEGMENTS + 2, TriangleFan, RenderStates(transform));
+    }
+};
+
+// --- Pré-aquecimento do cache de glifos ---
+// sf::Font rasteriza cada glifo na primeira vez que ele aparece em um
+// tamanho, aumentando a textura da página no meio do frame. Durante o
+// carregamento passamos por todos os caracteres e tamanhos que o jogo
+// pode mostrar. Compilando com -DGLYPH_CACHE_DEBUG=1, todo glifo que
+// escapar do pré-aquecimento é contado e avisado no console.
+#ifndef GLYPH_CACHE_DEBUG
+#define GLYPH_CACHE_DEBUG 0
+#endif
+
+// Acentos do português. Os textos do jogo são UTF-8 (MESSAGES e catálogos)
+// e passam por String::fromUtf8, aqui e na hora de mostrar
+#define GLYPH_ACCENTS "áàâãéêíóôõúüçÁÀÂÃÉÊÍÓÔÕÚÜÇ"
+
+struct TextStyle {
+    unsigned size;
+    bool bold;
+};
+
+// Todos os tamanhos/pesos de sf::Text usados pelo jogo
+constexpr TextStyle GAME_TEXT_STYLES[] = {
+    {24, false}, // Lixeiras e volume
+    {28, false}, // Histórias
+    {32, false}, // Fase
+    {36, false}, // Botão continuar
+    {36, true},  // Transição de fase
+    {42, false}, // Botão começar
+    {42, true},  // Mensagens e derrota
+    {48, false}  // Título
+};
+
+class GlyphCache {
+public:
+    unordered_set<Uint64> warmed;
+    int lateGlyphs = 0; // Rasterizados depois do carregamento
+
+    static Uint64 key(unsigned size, bool bold, Uint32 codePoint) {
+        return (static_cast<Uint64>(size) << 33) | (static_cast<Uint64>(bold) << 32) | codePoint;
+    }
+
+    void prewarm(const Font& font, const TextStyle& style, const String& text) {
+        for (Uint32 codePoint : text) {
+            if (codePoint < 32) {
+                continue; // Quebras de linha não viram glifos
+            }
+            font.getGlyph(codePoint, style.size, style.bold);
+            warmed.insert(key(style.size, style.bold, codePoint));
+        }
+    }
+
+    void prewarmAll(const Font& font) {
+        string printable;
+        for (char c = 32; c < 127; ++c) {
+            printable += c;
+        }
+        const char* accents = GLYPH_ACCENTS;
+        String accentString = String::fromUtf8(accents, accents + strlen(accents));
+        for (const TextStyle& style : GAME_TEXT_STYLES) {
+            prewarm(font, style, printable);
+            prewarm(font, style, accentString);
+        }
+    }
+
+    // Só no modo debug: registra glifos que ainda não estavam no cache
+    void track(const String& text, unsigned size, bool bold) {
+        if (!GLYPH_CACHE_DEBUG) {
+            return;
+        }
+        for (Uint32 codePoint : text) {
+            if (codePoint < 32) {
+                continue;
+            }
+            if (warmed.insert(key(size, bold, codePoint)).second) {
+                lateGlyphs++;
+                cerr << "Glifo rasterizado apos o carregamento: U+" << hex << codePoint << dec
+                     << " tamanho " << size << (bold ? " negrito" : "")
+                     << " (total " << lateGlyphs << ")" << endl;
+            }
+        }
+    }
+};
+
+// --- Atlas de glifos do HUD ---
+// Pontuação, combo e vidas mudam quase todo frame, e cada string nova num
+// sf::Text refaz o layout dos glifos. Aqui os caracteres do HUD são
+// rasterizados uma vez numa textura própria e os números viram quads
+// escritos direto num buffer de vértices de tamanho fixo. As letras vêm dos
+// textos MSG_HUD_* do idioma escolhido; o resto do HUD só usa estes símbolos.
+#define HUD_SYMBOLS "0123456789%x.: "
+#define HUD_MAX_QUADS 256
+
+enum HudStyle {
+    HUD_LARGE,      // Pontuação e combo
+    HUD_LARGE_BOLD, // Multiplicador e escudos
+    HUD_MEDIUM,     // Reputação
+    HUD_SMALL,      // Multiplicador do combo boost
+    HUD_SMALL_BOLD, // Vidas na fase do boss
+    HUD_STYLE_COUNT
+};
+
+struct HudStyleInfo {
+    unsigned size;
+    bool bold;
+};
+
+constexpr HudStyleInfo HUD_STYLES[HUD_STYLE_COUNT] = {
+    {36, false},
+    {36, true},
+    {32, false},
+    {30, false},
+    {30, true}
+};
+
+class HudAtlas {
+public:
+    struct GlyphQuad {
+        FloatRect bounds;  // Relativo à linha de base, como em sf::Glyph
+        FloatRect texRect; // Posição no atlas
+        float advance = 0;
+    };
+
+    Texture texture;
+    GlyphQuad glyphs[HUD_STYLE_COUNT][128];
+
+    // charset: caracteres ASCII que o HUD pode mostrar
+    bool build(const Font& font, const string& charset) {
+        // Carrega todos os glifos antes de copiar as páginas da fonte,
+        // que podem ser realocadas enquanto crescem
+        for (int s = 0; s < HUD_STYLE_COUNT; ++s) {
+            for (const char* c = charset.c_str(); *c; ++c) {
+                font.getGlyph(*c, HUD_STYLES[s].size, HUD_STYLES[s].bold);
+            }
+        }
+
+        // Empacota em prateleiras, com 1 pixel de folga entre glifos
+        const unsigned width = 512;
+        unsigned penX = 1, penY = 1, rowHeight = 0;
+        IntRect placed[HUD_STYLE_COUNT][128];
+        for (int s = 0; s < HUD_STYLE_COUNT; ++s) {
+            for (const char* c = charset.c_str(); *c; ++c) {
+                const IntRect& rect = font.getGlyph(*c, HUD_STYLES[s].size, HUD_STYLES[s].bold).textureRect;
+                if (penX + rect.width + 1 > width) {
+                    penX = 1;
+                    penY += rowHeight + 1;
+                    rowHeight = 0;
+                }
+                placed[s][static_cast<int>(*c)] = IntRect(penX, penY, rect.width, rect.height);
+                penX += rect.width + 1;
+                rowHeight = max(rowHeight, static_cast<unsigned>(rect.height));
+            }
+        }
+
+        Image atlas;
+        atlas.create(width, penY + rowHeight + 1, Color(255, 255, 255, 0));
+        for (int s = 0; s < HUD_STYLE_COUNT; ++s) {
+            Image page = font.getTexture(HUD_STYLES[s].size).copyToImage();
+            for (const char* c = charset.c_str(); *c; ++c) {
+                const Glyph& glyph = font.getGlyph(*c, HUD_STYLES[s].size, HUD_STYLES[s].bold);
+                const IntRect& target = placed[s][static_cast<int>(*c)];
+                if (target.width > 0 && target.height > 0) {
+                    atlas.copy(page, target.left, target.top, glyph.textureRect);
+                }
+                GlyphQuad& quad = glyphs[s][static_cast<int>(*c)];
+                quad.bounds = glyph.bounds;
+                quad.texRect = FloatRect(target.left, target.top, target.width, target.height);
+                quad.advance = glyph.advance;
+            }
+        }
+        return texture.loadFromImage(atlas);
+    }
+
+    float measure(HudStyle style, const char* text) const {
+        float width = 0;
+        for (const char* c = text; *c; ++c) {
+            width += glyphs[style][*c & 127].advance;
+        }
+        return width;
+    }
+};
+
+// Emissor de quads do HUD: acumula os textos do frame e desenha tudo de uma vez
+class HudText {
+public:
+    const HudAtlas* atlas = nullptr;
+    vector<Vertex> vertices;
+    size_t quadCount = 0;
+
+    HudText() {
+        vertices.resize(HUD_MAX_QUADS * 4);
+    }
+
+    // Mesma origem do sf::Text: topo da linha a characterSize acima da base.
+    // Retorna o x em que o texto termina.
+    float add(HudStyle style, const char* text, Vector2f position, Color color) {
+        float penX = position.x;
+        float baseline = position.y + HUD_STYLES[style].size;
+        for (const char* c = text; *c && quadCount < HUD_MAX_QUADS; ++c) {
+            const HudAtlas::GlyphQuad& glyph = atlas->glyphs[style][*c & 127];
+            float left = penX + glyph.bounds.left;
+            float top = baseline + glyph.bounds.top;
+            float right = left + glyph.bounds.width;
+            float bottom = top + glyph.bounds.height;
+            float u0 = glyph.texRect.left, v0 = glyph.texRect.top;
+            float u1 = u0 + glyph.texRect.width, v1 = v0 + glyph.texRect.height;
+
+            Vertex* quad = &vertices[quadCount * 4];
+            quad[0] = Vertex(Vector2f(left, top), color, Vector2f(u0, v0));
+            quad[1] = Vertex(Vector2f(right, top), color, Vector2f(u1, v0));
+            quad[2] = Vertex(Vector2f(right, bottom), color, Vector2f(u1, v1));
+            quad[3] = Vertex(Vector2f(left, bottom), color, Vector2f(u0, v1));
+            quadCount++;
+            penX += glyph.advance;
+        }
+        return penX;
+    }
+
+    template <typename... Args>
+    float print(HudStyle style, Vector2f position, Color color, const char* format, Args... args) {
+        char buffer[64];
+        snprintf(buffer, sizeof(buffer), format, args...);
+        return add(style, buffer, position, color);
+    }
+
+    void draw(RenderBackend& target) {
+        if (quadCount > 0) {
+            target.draw(vertices.data(), quadCount * 4, Quads, RenderStates(&atlas->texture));
+        }
+        quadCount = 0;
+    }
+};
+
+// --- Catálogo de textos ---
+// Cada idioma é um arquivo compilado por --build-catalog a partir de um
+// texto "chave = valor". Na abertura o arquivo é mapeado na memória e os
+// textos são usados direto das páginas mapeadas, sem cópia nem parse.
+// Formato, com inteiros de 32 bits little-endian:
+//   "RCAT", versão, N
+//   N entradas ordenadas por hash: hash FNV-1a da chave, início, tamanho
+//   os textos em UTF-8, cada um terminado em '\0'
+#define CATALOG_MAGIC "RCAT"
+#define CATALOG_VERSION 1
+#define CATALOG_HEADER_BYTES 12
+#define CATALOG_ENTRY_BYTES 12
+
+#ifndef _WIN32 // No Windows, CreateFileMapping e afins vêm do <windows.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Arquivo só de leitura mapeado na memória; as páginas vêm do disco sob demanda
+class MappedFile {
+public:
+    const char* data = nullptr;
+    size_t size = 0;
+
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() {
+        close();
+    }
+
+    bool open(const string& filename) {
+        close();
+#ifdef _WIN32
+        HANDLE handle = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                    FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (handle == INVALID_HANDLE_VALUE) return false;
+        DWORD length = GetFileSize(handle, nullptr);
+        HANDLE mapping = length > 0 && length != INVALID_FILE_SIZE
+                             ? CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+        LPVOID view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+        // A visão continua válida depois de fechar os handles
+        if (mapping) CloseHandle(mapping);
+        CloseHandle(handle);
+        if (view == nullptr) return false;
+        data = static_cast<const char*>(view);
+        size = length;
+#else
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat info;
+        void* view = MAP_FAILED;
+        if (fstat(fd, &info) == 0 && info.st_size > 0) {
+            view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        ::close(fd);
+        if (view == MAP_FAILED) return false;
+        data = static_cast<const char*>(view);
+        size = static_cast<size_t>(info.st_size);
+#endif
+        return true;
+    }
+
+    void close() {
+        if (data == nullptr) return;
+#ifdef _WIN32
+        UnmapViewOfFile(data);
+#else
+        munmap(const_cast<char*>(data), size);
+#endif
+        data = nullptr;
+        size = 0;
+    }
+};
+
+class Catalog {
+public:
+    Catalog() {
+        reset();
+    }
+
+    // Textos de MESSAGES para as chaves que o arquivo não tiver
+    bool load(const string& filename) {
+        reset();
+        if (!file.open(filename)) {
+            cerr << "Erro ao abrir catalogo: " << filename << endl;
+            return false;
+        }
+        const char* data = file.data;
+        size_t size = file.size;
+        Uint32 count = size >= CATALOG_HEADER_BYTES ? readU32(data + 8) : 0;
+        if (size < CATALOG_HEADER_BYTES || memcmp(data, CATALOG_MAGIC, 4) != 0 ||
+            readU32(data + 4) != CATALOG_VERSION || count > (size - CATALOG_HEADER_BYTES) / CATALOG_ENTRY_BYTES) {
+            cerr << "Erro ao ler catalogo: " << filename << endl;
+            file.close();
+            return false;
+        }
+
+        const char* entries = data + CATALOG_HEADER_BYTES;
+        size_t textStart = CATALOG_HEADER_BYTES + static_cast<size_t>(count) * CATALOG_ENTRY_BYTES;
+        for (int id = 0; id < MSG_COUNT; ++id) {
+            // Busca binária pelo hash da chave
+            Uint32 wanted = hash(MESSAGES[id].key);
+            Uint32 low = 0, high = count;
+            while (low < high) {
+                Uint32 middle = (low + high) / 2;
+                if (readU32(entries + middle * CATALOG_ENTRY_BYTES) < wanted) low = middle + 1;
+                else high = middle;
+            }
+            const char* entry = entries + low * CATALOG_ENTRY_BYTES;
+            if (low == count || readU32(entry) != wanted) continue;
+
+            size_t offset = readU32(entry + 4), length = readU32(entry + 8);
+            if (offset < textStart || offset + length >= size || data[offset + length] != '\0') {
+                cerr << "Erro ao ler catalogo: " << filename << " (texto fora do arquivo)" << endl;
+                continue;
+            }
+            const char* text = data + offset;
+            if (!accepts(static_cast<MessageId>(id), text)) {
+                cerr << "Erro no catalogo " << filename << ": texto invalido para " << MESSAGES[id].key << endl;
+                continue;
+            }
+            texts[id] = text;
+        }
+        return true;
+    }
+
+    // UTF-8, terminado em '\0'; aponta para o arquivo mapeado ou para MESSAGES
+    const char* text(MessageId id) const {
+        return texts[id];
+    }
+
+    String decode(MessageId id) const {
+        return String::fromUtf8(texts[id], texts[id] + strlen(texts[id]));
+    }
+
+    // Fonte "chave = valor" (uma por linha, '#' comenta, \n quebra a linha) para o formato binário
+    static bool compile(const string& sourceFile, const string& outputFile) {
+        ifstream in(sourceFile);
+        if (!in) {
+            cerr << "Erro ao abrir fonte do catalogo: " << sourceFile << endl;
+            return false;
+        }
+        map<Uint32, string> entries; // Por hash, já na ordem do arquivo
+        vector<bool> found(MSG_COUNT, false);
+        string line;
+        for (int lineNumber = 1; getline(in, line); ++lineNumber) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            size_t start = line.find_first_not_of(" \t");
+            if (start == string::npos || line[start] == '#') continue;
+
+            size_t equals = line.find('=');
+            int id = -1;
+            string key = equals == string::npos ? string() : trim(line.substr(0, equals));
+            for (int i = 0; i < MSG_COUNT; ++i) {
+                if (key == MESSAGES[i].key) id = i;
+            }
+            if (id < 0) {
+                cerr << "Erro no catalogo " << sourceFile << ":" << lineNumber << ": chave desconhecida '" << key << "'" << endl;
+                return false;
+            }
+            string value = unescape(trim(line.substr(equals + 1)));
+            if (!accepts(static_cast<MessageId>(id), value.c_str())) {
+                cerr << "Erro no catalogo " << sourceFile << ":" << lineNumber << ": " << key
+                     << " precisa dos mesmos %d/%s do original" << (id >= MSG_HUD_SCORE ? " e so ASCII" : "") << endl;
+                return false;
+            }
+            entries[hash(key.c_str())] = value;
+            found[id] = true;
+        }
+
+        string header, table, texts;
+        header.append(CATALOG_MAGIC, 4);
+        putU32(header, CATALOG_VERSION);
+        putU32(header, static_cast<Uint32>(entries.size()));
+        size_t textStart = CATALOG_HEADER_BYTES + entries.size() * CATALOG_ENTRY_BYTES;
+        for (const auto& entry : entries) {
+            putU32(table, entry.first);
+            putU32(table, static_cast<Uint32>(textStart + texts.size()));
+            putU32(table, static_cast<Uint32>(entry.second.size()));
+            texts += entry.second;
+            texts += '\0';
+        }
+
+        ofstream out(outputFile, ios::binary);
+        out << header << table << texts;
+        if (!out) {
+            cerr << "Erro ao gravar catalogo: " << outputFile << endl;
+            return false;
+        }
+        for (int id = 0; id < MSG_COUNT; ++id) {
+            if (!found[id]) {
+                cout << "Sem traducao (fica o portugues): " << MESSAGES[id].key << endl;
+            }
+        }
+        cout << "Catalogo: " << entries.size() << " textos em " << outputFile << endl;
+        return true;
+    }
+
+    static Uint32 hash(const char* key) {
+        Uint32 h = 2166136261u;
+        for (const char* c = key; *c; ++c) {
+            h = (h ^ static_cast<unsigned char>(*c)) * 16777619u;
+        }
+        return h;
+    }
+
+private:
+    MappedFile file;
+    const char* texts[MSG_COUNT];
+
+    void reset() {
+        file.close();
+        for (int id = 0; id < MSG_COUNT; ++id) {
+            texts[id] = MESSAGES[id].text;
+        }
+    }
+
+    // A tradução é formatada com os mesmos argumentos do original e os
+    // textos do HUD passam pelo atlas, que só tem ASCII
+    static bool accepts(MessageId id, const char* text) {
+        if (conversions(text) != conversions(MESSAGES[id].text)) return false;
+        if (id >= MSG_HUD_SCORE) {
+            for (const char* c = text; *c; ++c) {
+                if (*c < 32 || *c > 126) return false;
+            }
+        }
+        return true;
+    }
+
+    // Sequência de conversões do printf ("%d", "%s"...), sem contar "%%"
+    static string conversions(const char* format) {
+        string result;
+        for (const char* c = format; *c; ++c) {
+            if (*c != '%') continue;
+            ++c;
+            while (*c && strchr("-+ #0123456789.", *c)) ++c;
+            if (*c == '\0') {
+                result += '?'; // '%' solto no fim
+                break;
+            }
+            if (*c != '%') result += *c;
+        }
+        return result;
+    }
+
+    static Uint32 readU32(const char* p) {
+        const unsigned char* b = reinterpret_cast<const unsigned char*>(p);
+        return b[0] | (b[1] << 8) | (b[2] << 16) | (static_cast<Uint32>(b[3]) << 24);
+    }
+
+    static void putU32(string& out, Uint32 value) {
+        for (int i = 0; i < 4; ++i) {
+            out += static_cast<char>((value >> (8 * i)) & 0xFF);
+        }
+    }
+
+    static string trim(const string& s) {
+        size_t first = s.find_first_not_of(" \t");
+        size_t last = s.find_last_not_of(" \t");
+        return first == string::npos ? string() : s.substr(first, last - first + 1);
+    }
+
+    static string unescape(const string& s) {
+        string result;
+        for (size_t i = 0; i < s.size(); ++i) {
+            if (s[i] == '\\' && i + 1 < s.size() && (s[i + 1] == 'n' || s[i + 1] == '\\')) {
+                result += s[++i] == 'n' ? '\n' : '\\';
+            } else {
+                result += s[i];
+            }
+        }
+        return result;
+    }
+};
+
+// Texto com o layout pronto. Os fixos são montados uma vez no carregamento
+// e os outros (mensagens com números, resultado do versus) só quando o
+// texto muda. Desenhar é copiar os vértices na posição e na cor do momento,
+// sem passar glifo por glifo como Text faz nos backends.
+class TextRun {
+public:
+    vector<Vertex> vertices; // Quads relativos ao canto do texto, em branco
+    FloatRect bounds;        // Como Text::getLocalBounds
+    const Texture* texture = nullptr; // Página da fonte no tamanho do texto
+    Vector2f position;
+    Vector2f origin;
+    Color color = Color::White;
+
+    void shape(const Font& font, const String& text, unsigned size, bool bold) {
+        vertices.clear();
+        layoutText(font, text, size, bold, Transform::Identity, Color::White, vertices);
+        texture = &font.getTexture(size);
+        if (vertices.empty()) {
+            bounds = FloatRect();
+            return;
+        }
+        Vector2f low = vertices[0].position, high = low;
+        for (const Vertex& vertex : vertices) {
+            low.x = min(low.x, vertex.position.x);
+            low.y = min(low.y, vertex.position.y);
+            high.x = max(high.x, vertex.position.x);
+            high.y = max(high.y, vertex.position.y);
+        }
+        bounds = FloatRect(low, high - low);
+    }
+
+    // Copia só o texto montado; posição, origem e cor ficam
+    void assign(const TextRun& other) {
+        vertices = other.vertices;
+        bounds = other.bounds;
+        texture = other.texture;
+    }
+
+    bool empty() const {
+        return vertices.empty();
+    }
+
+    void clear() {
+        vertices.clear();
+    }
+
+    // scratch: buffer do frame, reaproveitado entre textos
+    void draw(RenderBackend& target, vector<Vertex>& scratch) const {
+        if (vertices.empty()) return;
+        Vector2f offset = position - origin;
+        scratch.resize(vertices.size());
+        for (size_t i = 0; i < vertices.size(); ++i) {
+            scratch[i] = Vertex(vertices[i].position + offset, color, vertices[i].texCoords);
+        }
+        target.draw(scratch.data(), scratch.size(), Quads, RenderStates(texture));
+    }
+
+    // Na camada estática, direto na textura (só em branco)
+    void draw(RenderTarget& target) const {
+        if (vertices.empty()) return;
+        RenderStates states(texture);
+        states.transform.translate(position - origin);
+        target.draw(vertices.data(), vertices.size(), Quads, states);
+    }
+};
+
+// --- Rastreamento de alocações ---
+// Modo opcional (compile com -DALLOC_TRACKING=1) que substitui o operator
+// new/delete global e conta alocações e bytes por frame e por escopo. Um
+// frame que passa do orçamento (--alloc-budget N, padrão 0) é reportado com
+// a pilha de chamadas da alocação que estourou. Só a thread do jogo é
+// contada; as threads de áudio do SFML ficam de fora. As versões alinhadas
+// do operator new não são substituídas: o jogo não tem tipos superalinhados.
+#ifndef ALLOC_TRACKING
+#define ALLOC_TRACKING 0
+#endif
+
+#define ALLOC_WARMUP_FRAMES 120 // Vetores ainda crescendo até a capacidade final
+#define ALLOC_MAX_REPORTS 20
+#define ALLOC_STACK_DEPTH 32
+
+enum AllocScopeTag {
+    ALLOC_OTHER,
+    ALLOC_INPUT,
+    ALLOC_UPDATE,
+    ALLOC_RENDER,
+    ALLOC_AUDIO, // Sons e mensagens disparados pelos eventos da simulação
+    ALLOC_SCOPE_COUNT
+};
+
+const char* const ALLOC_SCOPE_NAMES[ALLOC_SCOPE_COUNT] = { "outros", "entrada", "update", "render", "audio" };
+
+#if ALLOC_TRACKING
+
+#ifndef _WIN32 // No Windows, RtlCaptureStackBackTrace vem do <windows.h>
+#include <execinfo.h>
+#endif
+
+class AllocTracker {
+public:
+    static inline thread_local bool tracked = false;
+    static inline thread_local bool busy = false; // Evita contar o próprio rastreador
+    static inline thread_local int scope = ALLOC_OTHER;
+
+    static inline long budget = 0;
+    static inline long frameIndex = 0;
+    static inline long frameCount = 0;
+    static inline size_t frameBytes = 0;
+    static inline long scopeCount[ALLOC_SCOPE_COUNT] = {};
+    static inline size_t scopeBytes[ALLOC_SCOPE_COUNT] = {};
+
+    static inline void* stack[ALLOC_STACK_DEPTH];
+    static inline int stackDepth = 0;
+    static inline int stackScope = ALLOC_OTHER;
+    static inline size_t stackSize = 0;
+
+    // Totais para o resumo final
+    static inline long framesOverBudget = 0;
+    static inline long worstFrame = 0;
+    static inline long totalCount[ALLOC_SCOPE_COUNT] = {};
+    static inline int reports = 0;
+
+    static void attach() {
+        tracked = true;
+    }
+
+    static void record(size_t size) {
+        if (!tracked || busy) return;
+        busy = true;
+        frameCount++;
+        frameBytes += size;
+        scopeCount[scope]++;
+        scopeBytes[scope] += size;
+        // Guarda a pilha da alocação que estourou o orçamento
+        if (frameCount == budget + 1 && frameIndex >= ALLOC_WARMUP_FRAMES) {
+#ifdef _WIN32
+            stackDepth = RtlCaptureStackBackTrace(1, ALLOC_STACK_DEPTH, stack, nullptr);
+#else
+            stackDepth = backtrace(stack, ALLOC_STACK_DEPTH);
+#endif
+            stackScope = scope;
+            stackSize = size;
+        }
+        busy = false;
+    }
+
+    static void endFrame() {
+        busy = true;
+        if (frameIndex >= ALLOC_WARMUP_FRAMES) {
+            worstFrame = max(worstFrame, frameCount);
+            for (int s = 0; s < ALLOC_SCOPE_COUNT; ++s) {
+                totalCount[s] += scopeCount[s];
+            }
+            if (frameCount > budget) {
+                framesOverBudget++;
+                if (reports++ < ALLOC_MAX_REPORTS) {
+                    report();
+                }
+            }
+        }
+        frameIndex++;
+        frameCount = 0;
+        frameBytes = 0;
+        stackDepth = 0;
+        fill(scopeCount, scopeCount + ALLOC_SCOPE_COUNT, 0);
+        fill(scopeBytes, scopeBytes + ALLOC_SCOPE_COUNT, 0);
+        busy = false;
+    }
+
+    static void report() {
+        fprintf(stderr, "Frame %ld: %ld alocacoes (%zu bytes), orcamento %ld\n", frameIndex, frameCount, frameBytes, budget);
+        for (int s = 0; s < ALLOC_SCOPE_COUNT; ++s) {
+            if (scopeCount[s] > 0) {
+                fprintf(stderr, "  %-8s %ld (%zu bytes)\n", ALLOC_SCOPE_NAMES[s], scopeCount[s], scopeBytes[s]);
+            }
+        }
+        fprintf(stderr, "  Alocacao que estourou (%s, %zu bytes):\n", ALLOC_SCOPE_NAMES[stackScope], stackSize);
+#ifdef _WIN32
+        // Endereços para o addr2line -e main.exe
+        for (int i = 0; i < stackDepth; ++i) {
+            fprintf(stderr, "    %p\n", stack[i]);
+        }
+#else
+        backtrace_symbols_fd(stack, stackDepth, 2);
+#endif
+    }
+
+    static void printSummary() {
+        busy = true;
+        long frames = max(0L, frameIndex - ALLOC_WARMUP_FRAMES);
+        fprintf(stderr, "Alocacoes apos %d frames de aquecimento: %ld frames, %ld acima do orcamento (%ld), pior frame %ld\n",
+                ALLOC_WARMUP_FRAMES, frames, framesOverBudget, budget, worstFrame);
+        for (int s = 0; s < ALLOC_SCOPE_COUNT; ++s) {
+            fprintf(stderr, "  %-8s %ld\n", ALLOC_SCOPE_NAMES[s], totalCount[s]);
+        }
+        busy = false;
+    }
+};
+
+// Marca as alocações feitas enquanto o objeto vive
+class AllocScope {
+public:
+    explicit AllocScope(AllocScopeTag tag) : previous(AllocTracker::scope) {
+        AllocTracker::scope = tag;
+    }
+    ~AllocScope() {
+        AllocTracker::scope = previous;
+    }
+
+private:
+    int previous;
+};
+
+// O GCC não reconhece o par malloc/free atrás dos operadores substituídos;
+// o aviso fica desligado só nas definições abaixo
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+static void* trackedAlloc(size_t size) {
+    void* p = malloc(size ? size : 1);
+    if (p) AllocTracker::record(size);
+    return p;
+}
+
+void* operator new(size_t size) {
+    void* p = trackedAlloc(size);
+    if (!p) throw bad_alloc();
+    return p;
+}
+
+void* operator new[](size_t size) {
+    void* p = trackedAlloc(size);
+    if (!p) throw bad_alloc();
+    return p;
+}
+
+void* operator new(size_t size, const nothrow_t&) noexcept {
+    return trackedAlloc(size);
+}
+
+void* operator new[](size_t size, const nothrow_t&) noexcept {
+    return trackedAlloc(size);
+}
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete[](void* p, size_t) noexcept { free(p); }
+void operator delete(void* p, const nothrow_t&) noexcept { free(p); }
+void operator delete[](void* p, const nothrow_t&) noexcept { free(p); }
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#else
+
+// Sem rastreamento tudo some na compilação
+class AllocTracker {
+public:
+    static inline long budget = 0;
+    static void attach() {}
+    static void endFrame() {}
+    static void printSummary() {}
+};
+
+class AllocScope {
+public:
+    explicit AllocScope(AllocScopeTag) {}
+};
+
+#endif
+
+// --- Ritmo de frames ---
+// O limite do SFML dorme com a resolução grosseira do sistema e costuma
+// passar do ponto. Aqui dormimos até um pouco antes do prazo e terminamos
+// em espera ativa. A margem vem de uma previsão do atraso do sleep (média
+// e desvio dos últimos atrasos medidos). A simulação continua a 60 ticks
+// por segundo em qualquer taxa de frames.
+#define FRAME_SPIN_MIN_US 200
+#define MAX_TICKS_PER_FRAME 4
+
+class FramePacer {
+public:
+    Clock clock;
+    Int64 period = 1000000 / SIM_TICK_RATE; // µs por frame
+    Int64 nextDeadline = -1;
+    float overshootMean = 1000.0f;    // Atraso médio do sleep (µs)
+    float overshootDeviation = 500.0f;
+    Int64 lastTickCheck = 0;
+    Int64 tickAccumulator = 0;
+
+    // Estatística dos intervalos entre apresentações
+    Int64 lastPresent = -1;
+    long frames = 0;
+    double intervalSum = 0, intervalSquares = 0;
+
+    Int64 now() const {
+        return clock.getElapsedTime().asMicroseconds();
+    }
+
+    void setRate(int fps) {
+        period = 1000000 / fps;
+    }
+
+    int rate() const {
+        return static_cast<int>(1000000 / period);
+    }
+
+    // Bloqueia até o prazo do próximo frame
+    void wait() {
+        Int64 start = now();
+        if (nextDeadline < 0 || start - nextDeadline > period) {
+            nextDeadline = start; // Atrasou mais de um frame: recomeça a grade
+        }
+
+        Int64 margin = max<Int64>(FRAME_SPIN_MIN_US, static_cast<Int64>(overshootMean + 2.0f * overshootDeviation));
+        Int64 remaining = nextDeadline - start;
+        if (remaining > margin) {
+            Int64 requested = remaining - margin;
+            sleep(microseconds(requested));
+            float overshoot = static_cast<float>(now() - start - requested);
+            overshootMean += (overshoot - overshootMean) * 0.1f;
+            overshootDeviation += (fabs(overshoot - overshootMean) - overshootDeviation) * 0.1f;
+        }
+        while (now() < nextDeadline) {
+            // Espera ativa pelo restante
+        }
+        nextDeadline += period;
+    }
+
+    void markPresented() {
+        Int64 t = now();
+        if (lastPresent >= 0) {
+            double interval = (t - lastPresent) / 1000.0;
+            intervalSum += interval;
+            intervalSquares += interval * interval;
+            frames++;
+        }
+        lastPresent = t;
+    }
+
+    // Ticks de simulação que venceram desde a última chamada. A tolerância
+    // de 1/8 de tick evita alternar entre 0 e 2 ticks por jitter.
+    int consumeTicks() {
+        const Int64 tick = 1000000 / SIM_TICK_RATE;
+        Int64 t = now();
+        tickAccumulator += t - lastTickCheck;
+        lastTickCheck = t;
+        int ticks = static_cast<int>((tickAccumulator + tick / 8) / tick);
+        if (ticks > MAX_TICKS_PER_FRAME) {
+            // Travou (janela arrastada, breakpoint): não tenta recuperar tudo
+            ticks = MAX_TICKS_PER_FRAME;
+            tickAccumulator = 0;
+        } else {
+            tickAccumulator -= ticks * tick;
+        }
+        return ticks;
+    }
+
+    void printStats() const {
+        if (frames == 0) {
+            return;
+        }
+        double mean = intervalSum / frames;
+        double variance = max(0.0, intervalSquares / frames - mean * mean);
+        cout << "Frames: " << frames << " | Intervalo medio: " << fixed << setprecision(2) << mean
+             << " ms | Desvio padrao: " << sqrt(variance) << " ms" << endl;
+    }
+};
+
+// --- Arena do frame ---
+// Strings e contêineres temporários do loop usam esta arena via std::pmr:
+// alocar só avança um ponteiro num buffer fixo, e reset() no início de
+// cada frame descarta tudo de uma vez. Se um frame passar do buffer, o
+// excesso vem do heap e fica registrado em overflowBytes.
+#define FRAME_ARENA_BYTES (32 * 1024)
+
+class FrameArena {
+public:
+    FrameArena() : buffer(new unsigned char[FRAME_ARENA_BYTES]),
+                   resource(buffer.get(), FRAME_ARENA_BYTES, &upstream) {}
+
+    void reset() {
+        resource.release();
+    }
+
+    pmr::memory_resource* get() {
+        return &resource;
+    }
+
+    // snprintf direto numa string da arena
+    template <typename... Args>
+    pmr::string format(const char* format, Args... args) {
+        pmr::string text(&resource);
+        int length = snprintf(nullptr, 0, format, args...);
+        text.resize(max(0, length));
+        snprintf(&text[0], text.size() + 1, format, args...);
+        return text;
+    }
+
+    size_t overflowBytes() const {
+        return upstream.allocated;
+    }
+
+private:
+    class OverflowResource : public pmr::memory_resource {
+    public:
+        size_t allocated = 0;
+
+    private:
+        void* do_allocate(size_t bytes, size_t alignment) override {
+            allocated += bytes;
+            return pmr::new_delete_resource()->allocate(bytes, alignment);
+        }
+        void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+            pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+        }
+        bool do_is_equal(const pmr::memory_resource& other) const noexcept override {
+            return this == &other;
+        }
+    };
+
+    unique_ptr<unsigned char[]> buffer;
+    OverflowResource upstream;
+    pmr::monotonic_buffer_resource resource;
+};
+
+// --- Entrada de ponteiro ---
+// Mouse e toque viram o mesmo evento, em coordenadas lógicas e com o
+// instante de chegada no relógio monotônico do FramePacer.
+struct PointerEvent {
+    enum Type {
+        DOWN,
+        MOVE,
+        UP
+    };
+
+    Type type;
+    Vector2f position;
+    Int64 timestamp; // µs
+};
+
+// Latência do evento até o window.display() que mostra seu efeito
+#define MAX_EVENTS_PER_FRAME 256
+
+#define LATENCY_BUCKET_MS 4
+#define LATENCY_BUCKETS 25 // O último acumula tudo acima de 96 ms
+
+class LatencyHistogram {
+public:
+    long buckets[LATENCY_BUCKETS] = {};
+    long count = 0;
+    double sum = 0;
+    double worst = 0;
+
+    void add(Int64 microsecondsElapsed) {
+        double ms = microsecondsElapsed / 1000.0;
+        int bucket = min(LATENCY_BUCKETS - 1, static_cast<int>(ms / LATENCY_BUCKET_MS));
+        buckets[bucket]++;
+        count++;
+        sum += ms;
+        worst = max(worst, ms);
+    }
+
+    void print() const {
+        if (count == 0) {
+            cout << "Nenhum evento de entrada medido" << endl;
+            return;
+        }
+        cout << "Latencia entrada -> tela: " << count << " eventos | media " << fixed << setprecision(1)
+             << sum / count << " ms | pior " << worst << " ms" << endl;
+        long largest = *max_element(buckets, buckets + LATENCY_BUCKETS);
+        for (int i = 0; i < LATENCY_BUCKETS; ++i) {
+            if (buckets[i] == 0) {
+                continue;
+            }
+            ostringstream label;
+            if (i == LATENCY_BUCKETS - 1) {
+                label << ">=" << i * LATENCY_BUCKET_MS << " ms";
+            } else {
+                label << i * LATENCY_BUCKET_MS << "-" << (i + 1) * LATENCY_BUCKET_MS << " ms";
+            }
+            cout << left << setw(10) << label.str() << right << setw(7) << buckets[i] << " "
+                 << string(max(1L, buckets[i] * 40 / largest), '#') << endl;
+        }
+    }
+};
+
+// --- Replays ---
+// A simulação é determinística: a semente da partida mais as entradas que
+// chegaram a ela, com o tick em que chegaram, reproduzem a partida inteira.
+// Toques só importam na partida; das outras telas só entram as trocas de
+// fase e o início do boss, que mudam a simulação.
+struct ReplayInput {
+    enum Type {
+        DOWN,
+        MOVE,
+        UP,
+        ADVANCE_PHASE,
+        START_BOSS
+    };
+
+    Uint64 tick; // sim.timers.now() quando a entrada foi aplicada
+    Type type;
+    Vector2f position;
+};
+
+class Replay {
+public:
+    unsigned seed = 0;
+    vector<ReplayInput> inputs;
+
+    void begin(unsigned sessionSeed) {
+        seed = sessionSeed;
+        inputs.clear();
+    }
+
+    void add(const Simulation& sim, ReplayInput::Type type, Vector2f position = Vector2f()) {
+        inputs.push_back(ReplayInput{sim.timers.now(), type, position});
+    }
+
+    bool save(const string& filename) const {
+        ofstream out(filename);
+        if (!out) {
+            cerr << "Erro ao gravar replay: " << filename << endl;
+            return false;
+        }
+        // 9 dígitos: o float volta exatamente igual na leitura
+        out << "reciclagem-replay 1\n" << "seed " << seed << "\n" << setprecision(9);
+        for (const auto& input : inputs) {
+            out << input.tick << " " << input.type << " " << input.position.x << " " << input.position.y << "\n";
+        }
+        return true;
+    }
+
+    bool load(const string& filename) {
+        ifstream in(filename);
+        string magic, key;
+        int version = 0;
+        if (!(in >> magic >> version >> key >> seed) || magic != "reciclagem-replay" || version != 1) {
+            cerr << "Erro ao ler replay: " << filename << endl;
+            return false;
+        }
+        inputs.clear();
+        ReplayInput input;
+        int type = 0;
+        while (in >> input.tick >> type >> input.position.x >> input.position.y) {
+            input.type = static_cast<ReplayInput::Type>(type);
+            inputs.push_back(input);
+        }
+        return true;
+    }
+};
+
+// Mesma entrada que o Game aplicou, agora vinda de um replay ou da rede
+void applyInput(Simulation& sim, const ReplayInput& input) {
+    switch (input.type) {
+        case ReplayInput::DOWN: sim.pointerDown(input.position); break;
+        case ReplayInput::MOVE: sim.pointerMove(input.position); break;
+        case ReplayInput::UP: sim.pointerUp(input.position); break;
+        case ReplayInput::ADVANCE_PHASE: sim.advancePhase(); break;
+        case ReplayInput::START_BOSS: sim.startBossFight(); break;
+    }
+}
+
+// Reaplica um Replay numa Simulation tick a tick
+class ReplayPlayer {
+public:
+    const Replay& replay;
+    size_t next = 0;
+
+    explicit ReplayPlayer(const Replay& r) : replay(r) {}
+
+    void start(Simulation& sim) {
+        sim.rng.seed(replay.seed);
+        sim.reset();
+        next = 0;
+    }
+
+    // Aplica as entradas do tick atual e avança um tick; false quando a partida acabou
+    bool step(Simulation& sim) {
+        while (next < replay.inputs.size() && replay.inputs[next].tick <= sim.timers.now()) {
+            applyInput(sim, replay.inputs[next++]);
+        }
+        // Se a entrada que libera a tela parada não veio, a gravação acabou aqui
+        if (!sim.running()) {
+            return false;
+        }
+        sim.tick();
+        return true;
+    }
+};
+
+// --- Versus com rollback ---
+// Dois jogadores, cada um com seu tabuleiro, e a mesma semente nos dois. Cada
+// acerto manda um resíduo extra para o adversário. As duas máquinas simulam
+// os dois tabuleiros. A entrada local entra VERSUS_INPUT_DELAY ticks depois
+// do toque. A remota, enquanto não chega, é prevista como "nenhum toque", o
+// caso mais comum. Quando chega diferente do previsto, a partida volta ao
+// snapshot daquele tick e ressimula até o presente dentro do mesmo frame.
+#define ROLLBACK_WINDOW 16      // Ticks que dá para voltar; além disso o jogo espera o adversário
+#define VERSUS_INPUT_RING 64    // Entradas guardadas por jogador
+#define VERSUS_INPUT_DELAY 2    // Ticks entre o toque local e o tick em que ele entra
+#define VERSUS_MAX_EVENTS 4     // Eventos de ponteiro por jogador e tick
+#define VERSUS_PORT 53100
+#define VERSUS_TIMEOUT 5.0f     // Segundos sem notícias do adversário
+#define VERSUS_CONNECT_TIMEOUT 60.0f
+#define VERSUS_CHECKSUM_TICKS 60 // Um resumo do estado confirmado por segundo vai para o adversário
+#define VERSUS_CHECKSUM_RING 8   // Resumos locais guardados para comparar com os que chegam atrasados
+
+// Eventos de ponteiro de um jogador num tick
+struct TickInput {
+    Uint8 count = 0;
+    ReplayInput::Type types[VERSUS_MAX_EVENTS] = {};
+    Vector2f positions[VERSUS_MAX_EVENTS];
+
+    // Movimentos seguidos viram um só; false com o tick cheio
+    bool add(ReplayInput::Type type, Vector2f position) {
+        if (type == ReplayInput::MOVE && count > 0 && types[count - 1] == ReplayInput::MOVE) {
+            positions[count - 1] = position;
+            return true;
+        }
+        if (count == VERSUS_MAX_EVENTS) return false;
+        types[count] = type;
+        positions[count] = position;
+        count++;
+        return true;
+    }
+
+    void applyTo(Simulation& sim) const {
+        for (int i = 0; i < count; ++i) {
+            applyInput(sim, ReplayInput{sim.timers.now(), types[i], positions[i]});
+        }
+    }
+
+    bool operator==(const TickInput& other) const {
+        if (count != other.count) return false;
+        for (int i = 0; i < count; ++i) {
+            if (types[i] != other.types[i] || positions[i] != other.positions[i]) return false;
+        }
+        return true;
+    }
+
+    bool operator!=(const TickInput& other) const {
+        return !(*this == other);
+    }
+};
+
+Packet& operator<<(Packet& packet, const TickInput& input) {
+    packet << input.count;
+    for (int i = 0; i < input.count; ++i) {
+        packet << static_cast<Uint8>(input.types[i]) << input.positions[i].x << input.positions[i].y;
+    }
+    return packet;
+}
+
+// Só toques: trocas de fase no versus são da simulação, não do jogador
+Packet& operator>>(Packet& packet, TickInput& input) {
+    input = TickInput();
+    Uint8 count = 0;
+    packet >> count;
+    for (int i = 0; i < count && packet; ++i) {
+        Uint8 type = 0;
+        Vector2f position;
+        packet >> type >> position.x >> position.y;
+        if (i >= VERSUS_MAX_EVENTS || type > ReplayInput::UP) {
+            input = TickInput();
+            return packet;
+        }
+        input.types[i] = static_cast<ReplayInput::Type>(type);
+        input.positions[i] = position;
+        input.count = static_cast<Uint8>(i + 1);
+    }
+    return packet;
+}
+
+// Os dois tabuleiros e o resultado; tudo o que o rollback precisa copiar
+class VersusMatch {
+public:
+    Simulation boards[2];
+    Uint32 tick = 0;    // Próximo tick a simular
+    int winner = -1;    // Jogador que venceu; 2 = empate
+    Uint32 endTick = 0; // Tick em que a partida foi decidida
+
+    void start(unsigned seed, const SpriteMetrics& metrics) {
+        for (auto& board : boards) {
+            // Sem boss: o megacentro não acaba e a partida termina na primeira derrota
+            board.params.scoreToBoss = numeric_limits<int>::max();
+            board.metrics = metrics;
+            board.rng.seed(seed);
+            board.garbageRng.seed(seed + 1);
+            board.reset();
+        }
+        tick = 0;
+        winner = -1;
+        endTick = 0;
+    }
+
+    void step(const TickInput inputs[2]) {
+        int sorted[2] = {0, 0};
+        for (int p = 0; p < 2; ++p) {
+            Simulation& board = boards[p];
+            board.events.clear();
+            if (!board.defeated) {
+                inputs[p].applyTo(board);
+            }
+            board.tick();
+
+            // Sem tela de transição: a próxima fase começa no mesmo tick
+            if (board.phaseComplete) {
+                board.events.erase(remove_if(board.events.begin(), board.events.end(),
+                    [](const SimEvent& e) {
+                        return e.type == SimEvent::PHASE_COMPLETE;
+                    }), board.events.end());
+                board.advancePhase();
+                board.pushMessage(MSG_PHASE_LABEL, Color::Yellow, board.phase);
+            }
+            for (const auto& event : board.events) {
+                if (event.type == SimEvent::CORRECT_SORT) {
+                    sorted[p]++;
+                }
+            }
+        }
+        boards[0].garbagePending += sorted[1];
+        boards[1].garbagePending += sorted[0];
+
+        if (winner < 0 && (boards[0].defeated || boards[1].defeated)) {
+            winner = (boards[0].defeated && boards[1].defeated) ? 2 : boards[0].defeated ? 1 : 0;
+            endTick = tick;
+        }
+        tick++;
+    }
+
+    // Resume o estado dos dois tabuleiros para comparar partidas
+    Uint64 checksum() const {
+        Uint64 hash = 1469598103934665603ull;
+        auto mix = [&hash](Uint64 value) {
+            hash = (hash ^ value) * 1099511628211ull;
+        };
+        auto bits = [](float value) {
+            Uint32 result;
+            memcpy(&result, &value, sizeof(result));
+            return result;
+        };
+        mix(tick);
+        mix(static_cast<Uint64>(winner + 1));
+        for (const auto& board : boards) {
+            mix(board.score);
+            mix(board.reputation);
+            mix(board.combo);
+            mix(board.phase);
+            mix(board.timers.now());
+            mix(board.nextWasteId);
+            mix(board.garbagePending);
+            mix(board.defeated);
+            for (const auto& waste : board.activeWastes) {
+                mix(waste.id);
+                mix(bits(waste.position.x));
+                mix(bits(waste.position.y));
+            }
+        }
+        return hash;
+    }
+
+    // Memória copiada a cada snapshot (os nós do map são estimados)
+    size_t snapshotBytes() const {
+        size_t bytes = sizeof(*this);
+        for (const auto& board : boards) {
+            bytes += board.timers.memoryBytes() - sizeof(board.timers);
+            bytes += board.activeWastes.capacity() * sizeof(Waste);
+            bytes += board.activePowerUps.capacity() * sizeof(PowerUp);
+            bytes += board.events.capacity() * sizeof(SimEvent);
+            bytes += board.binTypes.capacity() * sizeof(WasteType);
+            bytes += board.binPositions.capacity() * sizeof(Vector2f);
+            bytes += board.binBounds.size() * (sizeof(pair<const WasteType, FloatRect>) + 4 * sizeof(void*));
+        }
+        return bytes;
+    }
+};
+
+// Previsão, snapshots e ressimulação de um dos lados da partida
+class RollbackSession {
+public:
+    int local = 0;
+    VersusMatch match;          // Estado atual, com a entrada remota prevista
+    Uint32 remoteConfirmed = 0; // Entradas remotas conhecidas nos ticks anteriores a este
+
+    long rollbacks = 0;
+    long resimulatedTicks = 0;
+    Uint32 maxDepth = 0;
+    Int64 resimulateMicros = 0;
+
+    // Resumos do estado no início dos ticks múltiplos de VERSUS_CHECKSUM_TICKS,
+    // tirados só depois de confirmadas as duas entradas até ali
+    Uint32 checkedTick = 0; // Último tick resumido (0: nenhum)
+    bool desynced = false;  // Um resumo do adversário não bateu com o nosso
+
+    void start(int localPlayer, unsigned seed, const SpriteMetrics& metrics) {
+        local = localPlayer;
+        match.start(seed, metrics);
+        for (auto& slot : inputs) {
+            slot[0] = slot[1] = TickInput();
+        }
+        // Nos primeiros ticks ninguém tocou ainda: já estão confirmados
+        remoteConfirmed = VERSUS_INPUT_DELAY;
+        rollbackFrom = NO_ROLLBACK;
+        rollbacks = resimulatedTicks = 0;
+        maxDepth = 0;
+        resimulateMicros = 0;
+        checkedTick = 0;
+        pendingTick = 0;
+        desynced = false;
+    }
+
+    int remote() const {
+        return 1 - local;
+    }
+
+    // Ticks anteriores a este já têm entrada local
+    Uint32 localNext() const {
+        return match.tick + VERSUS_INPUT_DELAY;
+    }
+
+    const TickInput& localInput(Uint32 tick) const {
+        return inputs[tick % VERSUS_INPUT_RING][local];
+    }
+
+    // Sem o snapshot do primeiro tick não confirmado não há como corrigir: espera
+    bool canAdvance() const {
+        return match.tick < remoteConfirmed + ROLLBACK_WINDOW;
+    }
+
+    // Chegam em ordem; as repetidas (o link reenvia até confirmar) são ignoradas
+    void addRemoteInput(Uint32 tick, const TickInput& input) {
+        if (tick != remoteConfirmed || tick >= match.tick + VERSUS_INPUT_RING - ROLLBACK_WINDOW) return;
+        TickInput& slot = inputs[tick % VERSUS_INPUT_RING][remote()];
+        if (tick < match.tick && slot != input) {
+            rollbackFrom = min(rollbackFrom, tick);
+        }
+        slot = input;
+        remoteConfirmed++;
+    }
+
+    Uint64 checksumAt(Uint32 tick) const {
+        return checksums[tick / VERSUS_CHECKSUM_TICKS % VERSUS_CHECKSUM_RING];
+    }
+
+    // Resumo do adversário: compara já, se o nosso existe, ou quando sair
+    void addRemoteChecksum(Uint32 tick, Uint64 checksum) {
+        if (tick == 0 || tick % VERSUS_CHECKSUM_TICKS != 0) return;
+        if (tick <= checkedTick) {
+            if (checkedTick - tick < VERSUS_CHECKSUM_TICKS * VERSUS_CHECKSUM_RING && checksumAt(tick) != checksum) {
+                desynced = true;
+            }
+        } else if (tick > pendingTick) {
+            pendingTick = tick;
+            pendingChecksum = checksum;
+        }
+    }
+
+    // Volta ao primeiro tick previsto errado e refaz até o presente
+    void rollback() {
+        if (rollbackFrom >= match.tick) {
+            rollbackFrom = NO_ROLLBACK;
+            recordChecksums();
+            return;
+        }
+        Clock clock;
+        Uint32 present = match.tick;
+        Uint32 depth = present - rollbackFrom;
+        match = snapshots[rollbackFrom % ROLLBACK_WINDOW];
+        rollbackFrom = NO_ROLLBACK;
+        while (match.tick < present) {
+            simulate();
+        }
+        rollbacks++;
+        resimulatedTicks += depth;
+        maxDepth = max(maxDepth, depth);
+        resimulateMicros += clock.getElapsedTime().asMicroseconds();
+        recordChecksums();
+    }
+
+    // Registra a entrada local de localNext() e simula o tick atual
+    void advance(const TickInput& localInput) {
+        inputs[localNext() % VERSUS_INPUT_RING][local] = localInput;
+        rollback();
+        simulate();
+    }
+
+    // A derrota só vale depois de confirmadas as entradas até o tick dela
+    bool finished() const {
+        return rollbackFrom == NO_ROLLBACK && match.winner >= 0 && match.endTick < remoteConfirmed;
+    }
+
+private:
+    static constexpr Uint32 NO_ROLLBACK = numeric_limits<Uint32>::max();
+
+    TickInput inputs[VERSUS_INPUT_RING][2];
+    VersusMatch snapshots[ROLLBACK_WINDOW]; // Estado no início de cada tick; a cópia reaproveita a memória
+    Uint32 rollbackFrom = NO_ROLLBACK;
+    Uint64 checksums[VERSUS_CHECKSUM_RING] = {};
+    Uint32 pendingTick = 0; // Resumo do adversário à frente do nosso
+    Uint64 pendingChecksum = 0;
+
+    // Depois de corrigidas as previsões, o estado no início de um tick com as
+    // duas entradas anteriores confirmadas não muda mais. canAdvance() segura
+    // o presente a menos de ROLLBACK_WINDOW ticks do último confirmado, então
+    // o snapshot desse tick ainda está no anel.
+    void recordChecksums() {
+        for (Uint32 tick = checkedTick + VERSUS_CHECKSUM_TICKS; tick <= remoteConfirmed && tick <= match.tick;
+             tick += VERSUS_CHECKSUM_TICKS) {
+            const VersusMatch& state = tick == match.tick ? match : snapshots[tick % ROLLBACK_WINDOW];
+            checksums[tick / VERSUS_CHECKSUM_TICKS % VERSUS_CHECKSUM_RING] = state.checksum();
+            checkedTick = tick;
+            if (pendingTick == tick && pendingChecksum != checksumAt(tick)) {
+                desynced = true;
+            }
+        }
+    }
+
+    void simulate() {
+        Uint32 tick = match.tick;
+        TickInput* slot = inputs[tick % VERSUS_INPUT_RING];
+        if (tick >= remoteConfirmed) {
+            slot[remote()] = TickInput(); // Previsão: o adversário não tocou
+        }
+        snapshots[tick % ROLLBACK_WINDOW] = match;
+        match.step(slot);
+    }
+};
+
+// Primeiro byte de cada datagrama
+enum VersusMessage {
+    VERSUS_HELLO = 1, // quem entra -> anfitrião
+    VERSUS_START,     // anfitrião -> quem entra: semente
+    VERSUS_INPUTS     // entradas remotas confirmadas, último resumo (tick, checksum), primeiro tick, entradas locais sem confirmação
+};
+
+// UDP entre as duas máquinas. Cada pacote repete todas as entradas locais
+// que o outro lado ainda não confirmou, então um pacote perdido é coberto
+// pelo seguinte sem retransmissão explícita.
+class VersusLink {
+public:
+    int localPlayer = 0; // O anfitrião é o jogador 0
+    unsigned seed = 0;
+
+    bool host(unsigned short port) {
+        if (socket.bind(port) != Socket::Done) {
+            cerr << "Erro ao abrir a porta UDP " << port << endl;
+            return false;
+        }
+        socket.setBlocking(false);
+        localPlayer = 0;
+        seed = static_cast<unsigned>(time(0));
+        cout << "Aguardando adversario na porta " << port << "..." << endl;
+
+        Clock clock;
+        while (clock.getElapsedTime().asSeconds() < VERSUS_CONNECT_TIMEOUT) {
+            Packet packet;
+            IpAddress sender;
+            unsigned short senderPort = 0;
+            Uint8 type = 0;
+            if (socket.receive(packet, sender, senderPort) == Socket::Done && (packet >> type) && type == VERSUS_HELLO) {
+                peer = sender;
+                peerPort = senderPort;
+                sendStart();
+                lastHeard.restart();
+                cout << "Adversario conectado: " << peer.toString() << endl;
+                return true;
+            }
+            sleep(milliseconds(10));
+        }
+        cerr << "Erro ao conectar: nenhum adversario apareceu" << endl;
+        return false;
+    }
+
+    bool join(const string& address) {
+        size_t colon = address.rfind(':');
+        peer = IpAddress(address.substr(0, colon));
+        peerPort = (colon == string::npos) ? VERSUS_PORT : static_cast<unsigned short>(atoi(address.c_str() + colon + 1));
+        if (peer == IpAddress::None || socket.bind(Socket::AnyPort) != Socket::Done) {
+            cerr << "Erro ao conectar a " << address << endl;
+            return false;
+        }
+        socket.setBlocking(false);
+        localPlayer = 1;
+        cout << "Conectando a " << peer.toString() << ":" << peerPort << "..." << endl;
+
+        // HELLO repetido até o START chegar
+        Clock clock, retry;
+        bool first = true;
+        while (clock.getElapsedTime().asSeconds() < VERSUS_CONNECT_TIMEOUT) {
+            if (first || retry.getElapsedTime().asMilliseconds() > 250) {
+                Packet hello;
+                hello << static_cast<Uint8>(VERSUS_HELLO);
+                socket.send(hello, peer, peerPort);
+                retry.restart();
+                first = false;
+            }
+            Packet packet;
+            IpAddress sender;
+            unsigned short senderPort = 0;
+            Uint8 type = 0;
+            Uint32 startSeed = 0;
+            if (socket.receive(packet, sender, senderPort) == Socket::Done && sender == peer && senderPort == peerPort &&
+                (packet >> type >> startSeed) && type == VERSUS_START) {
+                seed = startSeed;
+                lastHeard.restart();
+                cout << "Conectado" << endl;
+                return true;
+            }
+            sleep(milliseconds(10));
+        }
+        cerr << "Erro ao conectar: " << address << " nao respondeu" << endl;
+        return false;
+    }
+
+    // Entradas do adversário; um HELLO repetido quer dizer que o START se perdeu
+    void receive(RollbackSession& session) {
+        Packet packet;
+        IpAddress sender;
+        unsigned short senderPort = 0;
+        while (socket.receive(packet, sender, senderPort) == Socket::Done) {
+            if (sender != peer || senderPort != peerPort) continue;
+            lastHeard.restart();
+            Uint8 type = 0;
+            packet >> type;
+            if (type == VERSUS_HELLO && localPlayer == 0) {
+                sendStart();
+            } else if (type == VERSUS_INPUTS) {
+                Uint32 ack = 0, checkedTick = 0, first = 0;
+                Uint64 checksum = 0;
+                Uint8 count = 0;
+                if (!(packet >> ack >> checkedTick >> checksum >> first >> count)) continue;
+                peerAck = max(peerAck, ack);
+                session.addRemoteChecksum(checkedTick, checksum);
+                for (Uint32 i = 0; i < count; ++i) {
+                    TickInput input;
+                    if (!(packet >> input)) break;
+                    session.addRemoteInput(first + i, input);
+                }
+            }
+        }
+    }
+
+    void send(const RollbackSession& session) {
+        Uint32 end = session.localNext();
+        // O anel só guarda as mais recentes; o outro lado para antes de precisar das antigas
+        Uint32 oldest = end > VERSUS_INPUT_RING - ROLLBACK_WINDOW ? end - (VERSUS_INPUT_RING - ROLLBACK_WINDOW) : 0;
+        Uint32 first = max(peerAck, oldest);
+        Packet packet;
+        packet << static_cast<Uint8>(VERSUS_INPUTS) << session.remoteConfirmed << session.checkedTick
+               << session.checksumAt(session.checkedTick) << first << static_cast<Uint8>(end - first);
+        for (Uint32 tick = first; tick < end; ++tick) {
+            packet << session.localInput(tick);
+        }
+        socket.send(packet, peer, peerPort);
+    }
+
+    bool timedOut() const {
+        return lastHeard.getElapsedTime().asSeconds() > VERSUS_TIMEOUT;
+    }
+
+private:
+    UdpSocket socket;
+    IpAddress peer;
+    unsigned short peerPort = 0;
+    Uint32 peerAck = VERSUS_INPUT_DELAY; // Os primeiros ticks não são enviados
+    Clock lastHeard;
+
+    void sendStart() {
+        Packet packet;
+        packet << static_cast<Uint8>(VERSUS_START) << static_cast<Uint32>(seed);
+        socket.send(packet, peer, peerPort);
+    }
+};
+
+// --- Registro de recursos ---
+// Texturas, sons e arquivos de fonte são carregados uma vez por processo e
+// compartilhados entre as sessões (várias janelas num quiosque, por
+// exemplo). Cada sessão guarda handles com contagem de referência; o
+// registro só guarda weak_ptr, então um recurso é liberado quando a última
+// sessão que o usa fecha. Depois de carregados, os recursos só são lidos;
+// por isso a sf::Font, que muda a cada glifo novo, fica em cada sessão.
+template <class T>
+using Asset = shared_ptr<const T>;
+
+// Textura de uma cor só, para quando o arquivo não carrega
+void fillTexture(Texture& texture, Vector2u size, Color color) {
+    texture.create(size.x, size.y);
+    vector<Uint8> pixels(size.x * size.y * 4);
+    for (size_t i = 0; i < pixels.size(); i += 4) {
+        pixels[i] = color.r;
+        pixels[i + 1] = color.g;
+        pixels[i + 2] = color.b;
+        pixels[i + 3] = color.a;
+    }
+    texture.update(pixels.data());
+}
+
+class AssetRegistry {
+public:
+    static AssetRegistry& shared() {
+        static AssetRegistry registry;
+        return registry;
+    }
+
+    // Sem o arquivo, uma textura lisa (rosa por padrão, para chamar atenção)
+    Asset<Texture> texture(const string& file, Vector2u fallbackSize = Vector2u(50, 50),
+                           Color fallbackColor = Color(255, 0, 255)) {
+        return acquire(textures, file, [&](Texture& texture) {
+            if (!texture.loadFromFile(file)) {
+                cerr << "Erro ao carregar textura: " << file << endl;
+                fillTexture(texture, fallbackSize, fallbackColor);
+            }
+        });
+    }
+
+    // Imagem já decodificada fora da trava (prefetch): só falta enviar para a GPU
+    Asset<Texture> texture(const string& file, const Image& image) {
+        return acquire(textures, file, [&](Texture& texture) {
+            texture.loadFromImage(image);
+        });
+    }
+
+    // Sem o arquivo, um buffer vazio: o som simplesmente não toca
+    Asset<SoundBuffer> sound(const string& file) {
+        return acquire(sounds, file, [&](SoundBuffer& buffer) {
+            if (!buffer.loadFromFile(file)) {
+                cerr << "Erro ao carregar som: " << file << endl;
+            }
+        });
+    }
+
+    // Bytes do primeiro arquivo que abrir. Só eles são divididos: a Font
+    // rasteriza glifos e cresce as texturas de página sempre que um texto
+    // é montado (layoutText, TextRun), então cada sessão abre a sua sobre
+    // estes bytes (loadFromMemory não copia; o Asset os mantém vivos)
+    Asset<vector<char>> fontFile(const vector<string>& files) {
+        return acquire(fontFiles, files.front(), [&](vector<char>& bytes) {
+            for (const auto& file : files) {
+                ifstream in(file, ios::binary);
+                if (in) {
+                    bytes.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+                    return;
+                }
+            }
+            cerr << "Erro ao carregar fonte" << endl;
+        });
+    }
+
+    // Recursos vivos e a memória que eles ocupam (pixels e amostras)
+    void printStats() {
+        lock_guard<mutex> guard(lock);
+        size_t count = 0, bytes = 0;
+        for (const auto& entry : textures) {
+            if (Asset<Texture> texture = entry.second.lock()) {
+                count++;
+                bytes += texture->getSize().x * texture->getSize().y * 4;
+            }
+        }
+        for (const auto& entry : sounds) {
+            if (Asset<SoundBuffer> buffer = entry.second.lock()) {
+                count++;
+                bytes += buffer->getSampleCount() * sizeof(Int16);
+            }
+        }
+        for (const auto& entry : fontFiles) {
+            if (Asset<vector<char>> file = entry.second.lock()) {
+                count++;
+                bytes += file->size();
+            }
+        }
+        cout << "Recursos compartilhados: " << count << " (" << bytes / (1024 * 1024) << " MB)" << endl;
+    }
+
+private:
+    mutex lock; // Carregar sob a trava: duas sessões nunca carregam o mesmo arquivo
+    map<string, weak_ptr<const Texture>> textures;
+    map<string, weak_ptr<const SoundBuffer>> sounds;
+    map<string, weak_ptr<const vector<char>>> fontFiles;
+
+    template <class T, class Load>
+    Asset<T> acquire(map<string, weak_ptr<const T>>& cache, const string& key, Load load) {
+        lock_guard<mutex> guard(lock);
+        Asset<T> asset = cache[key].lock();
+        if (!asset) {
+            shared_ptr<T> loaded = make_shared<T>();
+            load(*loaded);
+            asset = loaded;
+            cache[key] = asset;
+        }
+        return asset;
+    }
+};
+
+// --- Residência de texturas ---
+// O registro só guarda weak_ptr: quem mantém uma textura na memória de
+// vídeo é a sessão que segura o handle. A residência segura os handles de
+// uma sessão dentro de um orçamento. Cada tela declara o conjunto de
+// trabalho (fundo, resíduos e lixeiras da fase, ícones); o que ficou de
+// fora sai da memória, do usado há mais tempo para o mais recente, quando
+// o orçamento estoura. Na tela de transição uma thread decodifica as
+// imagens da próxima fase e o loop principal só envia os pixels prontos.
+#define TEXTURE_BUDGET_MB 32        // --texture-budget
+#define TEXTURE_UPLOADS_PER_FRAME 2 // Imagens pré-carregadas enviadas à GPU por frame
+
+struct TextureSpec {
+    const char* file;
+    Vector2u fallbackSize; // Sem o arquivo, textura lisa deste tamanho e cor
+    Color fallbackColor;
+};
+
+// Texturas que não dependem da fase
+enum UiTexture {
+    TEX_SOUND_ON,
+    TEX_SOUND_OFF,
+    TEX_COMBO_BOOST, // Na ordem de PowerUp::Type
+    TEX_TIME_FREEZE,
+    TEX_MAGNET,
+    TEX_SHIELD,
+    TEX_BOSS_DAMAGE,
+    TEX_PLAYER_PORTRAIT,
+    TEX_BOSS_PORTRAIT,
+    UI_TEXTURE_COUNT
+};
+
+const TextureSpec UI_TEXTURES[UI_TEXTURE_COUNT] = {
+    {"assets/textures/sound_on.png", Vector2u(50, 50), Color(255, 0, 255)},
+    {"assets/textures/sound_off.png", Vector2u(50, 50), Color(255, 0, 255)},
+    {"assets/textures/combo_boost.png", Vector2u(50, 50), Color(255, 255, 0)},
+    {"assets/textures/time_freeze.png", Vector2u(50, 50), Color(255, 255, 0)},
+    {"assets/textures/magnet.png", Vector2u(50, 50), Color(255, 255, 0)},
+    {"assets/textures/shield.png", Vector2u(50, 50), Color(255, 255, 0)},
+    {"assets/textures/boss_damage.png", Vector2u(50, 50), Color(255, 255, 0)},
+    {"assets/textures/player_portrait.png", Vector2u(50, 50), Color(0, 200, 0)},
+    {"assets/textures/boss_portrait.png", Vector2u(50, 50), Color(200, 0, 0)}
+};
+
+class TextureResidency {
+public:
+    size_t budget;            // Bytes; o conjunto de trabalho fica mesmo acima dele
+    size_t residentBytes = 0;
+    size_t peakBytes = 0;     // Maior ocupação depois de cada troca de conjunto ou envio
+    unsigned loads = 0;       // Decodificadas na hora, travando o frame
+    unsigned prefetched = 0;  // Decodificadas pela thread
+    unsigned evictions = 0;
+
+    TextureResidency(AssetRegistry& r, size_t budgetBytes) : budget(budgetBytes), registry(r) {
+        worker = thread([this] { work(); });
+    }
+
+    TextureResidency(const TextureResidency&) = delete;
+    TextureResidency& operator=(const TextureResidency&) = delete;
+
+    ~TextureResidency() {
+        {
+            lock_guard<mutex> guard(lock);
+            closing = true;
+        }
+        changed.notify_all();
+        worker.join();
+    }
+
+    // Troca o conjunto de trabalho. Os sprites só podem apontar para texturas
+    // dele: as outras podem ser despejadas a qualquer momento
+    void use(const vector<TextureSpec>& set) {
+        useClock++;
+        for (auto& entry : entries) {
+            entry.second.working = false;
+        }
+        for (const auto& spec : set) {
+            get(spec);
+            entries.find(spec.file)->second.working = true;
+        }
+        evict();
+    }
+
+    // Textura residente; se não estiver, carrega agora
+    const Texture& get(const TextureSpec& spec) {
+        auto it = entries.find(spec.file);
+        if (it == entries.end()) {
+            unique_ptr<Image> image = takeDecoded(spec.file);
+            it = insert(spec.file, image ? registry.texture(spec.file, *image)
+                                         : registry.texture(spec.file, spec.fallbackSize, spec.fallbackColor));
+            if (image) {
+                prefetched++;
+            } else {
+                loads++;
+            }
+        }
+        it->second.lastUse = useClock;
+        return *it->second.texture;
+    }
+
+    // Decodifica em outra thread o que ainda não está residente; pump() envia
+    void prefetch(const vector<TextureSpec>& set) {
+        useClock++;
+        {
+            lock_guard<mutex> guard(lock);
+            for (const auto& spec : set) {
+                auto it = entries.find(spec.file);
+                bool queued = find(requests.begin(), requests.end(), spec.file) != requests.end() ||
+                              any_of(decoded.begin(), decoded.end(), [&](const Decoded& d) { return d.file == spec.file; });
+                if (it != entries.end()) {
+                    it->second.lastUse = useClock; // Vai ser usada: fica para o fim da fila de despejo
+                } else if (!queued) {
+                    requests.push_back(spec.file);
+                }
+            }
+        }
+        changed.notify_all();
+    }
+
+    // No loop principal: sobe para a GPU algumas imagens já decodificadas
+    void pump() {
+        for (int i = 0; i < TEXTURE_UPLOADS_PER_FRAME; i++) {
+            unique_lock<mutex> guard(lock);
+            if (decoded.empty()) {
+                return;
+            }
+            Decoded& next = decoded.front();
+            if (next.image && entries.find(next.file) == entries.end()) {
+                // Sem espaço que não seja de outra pré-carregada: a imagem
+                // espera na RAM e sobe quando a fase começar (get)
+                size_t bytes = static_cast<size_t>(next.image->getSize().x) * next.image->getSize().y * 4;
+                if (residentBytes + bytes > budget + evictableBytes()) {
+                    return;
+                }
+                Decoded ready = move(next);
+                decoded.pop_front();
+                guard.unlock();
+                insert(ready.file, registry.texture(ready.file, *ready.image))->second.lastUse = useClock;
+                prefetched++;
+                evict();
+            } else {
+                decoded.pop_front(); // Já residente, ou o arquivo não abriu
+            }
+        }
+    }
+
+    void printStats() const {
+        cout << "Texturas: " << entries.size() << " residentes (" << residentBytes / (1024 * 1024) << " MB), pico "
+             << peakBytes / (1024 * 1024) << " MB de " << budget / (1024 * 1024) << " MB | "
+             << loads << " carregadas na hora, " << prefetched << " pre-carregadas, "
+             << evictions << " despejadas" << endl;
+    }
+
+    // Cada textura residente com o arquivo de onde veio
+    template <class Visit> void forEachResident(Visit visit) const {
+        for (const auto& entry : entries) {
+            visit(entry.first, *entry.second.texture);
+        }
+    }
+
+private:
+    struct Entry {
+        Asset<Texture> texture;
+        size_t bytes = 0;
+        Uint64 lastUse = 0;
+        bool working = false;
+    };
+
+    struct Decoded {
+        string file;
+        unique_ptr<Image> image; // nullptr: o arquivo não abriu; get() usa a textura lisa
+    };
+
+    AssetRegistry& registry;
+    map<string, Entry, less<>> entries; // less<>: busca por const char* sem montar string
+    Uint64 useClock = 0;
+
+    thread worker;
+    mutex lock;
+    condition_variable changed;
+    deque<string> requests;
+    deque<Decoded> decoded;
+    bool closing = false;
+
+    map<string, Entry, less<>>::iterator insert(const string& file, Asset<Texture> texture) {
+        Entry& entry = entries[file];
+        entry.bytes = static_cast<size_t>(texture->getSize().x) * texture->getSize().y * 4;
+        entry.texture = move(texture);
+        residentBytes += entry.bytes;
+        return entries.find(file);
+    }
+
+    // Fora do conjunto de trabalho, da usada há mais tempo para a mais recente
+    void evict() {
+        while (residentBytes > budget) {
+            auto victim = entries.end();
+            for (auto it = entries.begin(); it != entries.end(); ++it) {
+                if (!it->second.working && (victim == entries.end() || it->second.lastUse < victim->second.lastUse)) {
+                    victim = it;
+                }
+            }
+            if (victim == entries.end()) {
+                break; // Só sobrou o conjunto de trabalho
+            }
+            residentBytes -= victim->second.bytes;
+            entries.erase(victim);
+            evictions++;
+        }
+        peakBytes = max(peakBytes, residentBytes);
+    }
+
+    // O que dá para despejar sem tocar no conjunto de trabalho nem nas pré-carregadas
+    size_t evictableBytes() const {
+        size_t bytes = 0;
+        for (const auto& entry : entries) {
+            if (!entry.second.working && entry.second.lastUse < useClock) {
+                bytes += entry.second.bytes;
+            }
+        }
+        return bytes;
+    }
+
+    unique_ptr<Image> takeDecoded(const char* file) {
+        lock_guard<mutex> guard(lock);
+        for (auto it = decoded.begin(); it != decoded.end(); ++it) {
+            if (it->file == file) {
+                unique_ptr<Image> image = move(it->image);
+                decoded.erase(it);
+                return image;
+            }
+        }
+        return nullptr;
+    }
+
+    // Só decodifica: a textura é criada na thread do loop principal
+    void work() {
+        while (true) {
+            unique_lock<mutex> guard(lock);
+            changed.wait(guard, [this] { return !requests.empty() || closing; });
+            if (closing) {
+                return;
+            }
+            string file = move(requests.front());
+            requests.pop_front();
+            guard.unlock();
+
+            unique_ptr<Image> image = make_unique<Image>();
+            if (!image->loadFromFile(file)) {
+                image.reset();
+            }
+
+            guard.lock();
+            decoded.push_back(Decoded{move(file), move(image)});
+        }
+    }
+};
+
+// --- Camada estática ---
+// Fundo, lixeiras e nomes das lixeiras só mudam na troca de fase. São
+// compostos uma vez numa textura e desenhados como um único quad por frame.
+class StaticLayer {
+public:
+    RenderTexture texture;
+    Sprite sprite;
+    bool valid = false;
+    int phase = -1; // Fase para a qual a camada foi composta
+
+    bool create() {
+        if (!texture.create(MOBILE_RESOLUTION_X, MOBILE_RESOLUTION_Y)) {
+            return false;
+        }
+        texture.setSmooth(true); // A resolução dinâmica reduz a camada
+        sprite.setTexture(texture.getTexture(), true);
+        return true;
+    }
+
+    void invalidate() {
+        valid = false;
+    }
+
+    bool needsRebuild(int currentPhase) const {
+        return !valid || phase != currentPhase;
+    }
+
+    template <class Compose>
+    void rebuild(int currentPhase, Compose compose) {
+        texture.clear(Color::Transparent);
+        compose(texture);
+        texture.display();
+        valid = true;
+        phase = currentPhase;
+    }
+};
+
+class Game {
+private:
+    RenderWindow window;
+    RenderTexture canvas; // Alvo offscreen em coordenadas lógicas
+    DynamicResolution resolution;
+    unique_ptr<RenderBackend> renderer; // Todo desenho passa por aqui (--renderer)
+    Clock frameClock; // Intervalo entre apresentações
+    Clock workClock;  // Início do frame atual
+    FramePacer pacer;
+    Clock inputClock; // Último evento recebido; input recente força 60 fps
+    FrameArena frameArena; // Temporários do frame, descartados a cada volta do loop
+    int shownPhase = -1;
+    vector<PointerEvent> pendingInput; // Aplicados no próximo tick
+    vector<Int64> shownInput;          // Aplicados, aguardando o próximo display
+    LatencyHistogram inputLatency;
+    Vector2f touchStartPosition;
+    Simulation solo;
+    Simulation* sim = &solo; // Tabuleiro jogado e desenhado: solo, ou o local do versus
+    AssetRegistry& assets = AssetRegistry::shared();
+    TextureResidency textures; // Só as texturas da fase atual (e da próxima, na transição)
+    vector<Sprite> wasteSprites; // Um sprite por tipo, reposicionado a cada resíduo
+    vector<Sprite> bins;
+    vector<TextRun> binLabels;
+
+    Asset<vector<char>> fontFile; // Compartilhado entre as sessões
+    Font font;                    // Só desta sessão: os glifos são rasterizados sob demanda
+    Catalog catalog;          // --lang: textos do idioma escolhido
+    TextRun texts[MSG_COUNT]; // Textos fixos já montados (MESSAGES com tamanho e sem %)
+    vector<Vertex> textVertices; // Cópia dos TextRun desenhados no frame
+    TextRun phaseText;        // Remontado só na troca de fase
+    TextRun messageText;      // Cópia de texts[] ou montado com o número da mensagem
+    HudAtlas hudAtlas; // Glifos dos números do HUD
+    HudText hud;
+    GlyphCache glyphCache; // Glifos rasterizados no carregamento
+
+    RectangleShape reputationBar;
+    RectangleShape reputationBarBack;
+
+    Asset<SoundBuffer> correctBuffer;
+    Asset<SoundBuffer> wrongBuffer;
+    Asset<SoundBuffer> selectBuffer; // Novo buffer para seleção
+    Sound sound;
+
+    Clock powerUpClock;
+
+    // Novas variáveis para a tela inicial
+    bool inStartScreen = true;
+    RectangleShape startButton;
+    Music bgMusic;
+
+    // Variáveis para controle de som
+    Sprite soundIcon;
+    bool soundMuted = false;
+    RectangleShape volumeBar;
+    RectangleShape volumeFill;
+    bool volumeDragging = false;
+
+    // --- Adicione estas variáveis na sua classe Game ---
+    Sprite bgSprite;
+    StaticLayer staticLayer; // bgSprite + bins + binLabels da fase atual
+    Sprite playerPortrait, bossPortrait; // Sprites para retratos
+    bool inLevelTransition = false;
+    bool inIntroStory = false; // Nova tela de introdução
+    bool inBossIntro = false; // Introdução para o boss
+    RectangleShape continueButton;
+    TextRun levelInfoText;
+    RectangleShape storyPanel; // Painel para fundo da história
+    RectangleShape storyBg;
+    RectangleShape overlay; // Escurece o fundo no menu e na derrota
+    TextRun defeatText;
+
+    Asset<SoundBuffer> victoryBuffer, defeatBuffer;
+    Sound victorySound, defeatSound;
+    bool inDefeatScreen = false;
+
+    vector<PowerUp::Type> inventory; // Inventário do jogador (máximo de 2)
+    Asset<SoundBuffer> powerUpBuffer; // Som ao coletar power-up
+    Sound powerUpSound;
+
+    vector<Sprite> powerUpSprites;   // Um sprite por tipo de power-up
+    GlowMesh powerUpGlow;            // Brilho compartilhado por todos os power-ups
+    ParticleSystem particles;        // Faíscas de acerto, erro e power-ups
+
+    // Visualização de power-ups ativos
+    vector<Sprite> activePowerUpIcons;
+    vector<RectangleShape> activePowerUpTimers;
+    vector<Text> activePowerUpCounts;
+    Sprite effectIcon;          // Reaproveitados a cada frame
+    RectangleShape effectBar;
+
+    // Texto de feedback: some junto com a simulação (pausa na transição de fase)
+    enum UiTimerKind { MESSAGE_CLEAR };
+    TimerWheel uiTimers;
+    TimerWheel::Handle messageTimer;
+    Uint64 messageShownTick = 0;
+
+    // Roteiro das telas (campaign); os toques fora da partida viram sinais
+    enum UiSignal {
+        UI_START,      // Botão Começar
+        UI_TAP,        // Toque numa tela de roteiro, em lastTap
+        UI_ROUND_OVER  // Fase concluída ou derrota
+    };
+    ScriptRunner ui;
+    Vector2f lastTap;
+
+    // --- Novas variáveis para a fase do boss ---
+    RectangleShape playerLifeBar;
+    RectangleShape bossLifeBar;
+    RectangleShape playerLifeBarBack; // Fundo da barra de vida do jogador
+    RectangleShape bossLifeBarBack;    // Fundo da barra de vida do boss
+
+    bool vsync;      // --vsync
+    bool frameStats; // --frame-stats: imprime a variação dos frames ao sair
+    bool latencyStats; // --input-latency: imprime o histograma de latência ao sair
+    string replayFile;  // --record: grava a última partida jogada
+    Replay replay;
+
+    // --versus-host / --versus-join: sim aponta para o tabuleiro local da partida
+    unique_ptr<VersusLink> versusLink;
+    unique_ptr<RollbackSession> versus; // Só existe no versus: as cópias dos tabuleiros não pesam no jogo solo
+    TickInput versusInput; // Toques locais do próximo tick
+
+public:
+    // --- No construtor ---
+    // windowed = false: sem janela, som nem roteiro de telas, para desenhar
+    // partidas dirigidas de fora (--export-replay, --render-bench)
+    Game(bool useVsync = false, bool showFrameStats = false, bool showLatencyStats = false,
+         const string& rendererName = "sfml", const string& recordFile = "", const string& language = "pt",
+         size_t textureBudgetMb = TEXTURE_BUDGET_MB, bool windowed = true)
+        : solo(BalanceParams(), static_cast<unsigned>(time(0))), textures(assets, textureBudgetMb * 1024 * 1024),
+          inStartScreen(true),
+          vsync(useVsync), frameStats(showFrameStats), latencyStats(showLatencyStats),
+          replayFile(recordFile) {
+        if (windowed) {
+            window.create(VideoMode(MOBILE_RESOLUTION_X, MOBILE_RESOLUTION_Y), "Gerenciador de Reciclagem");
+        }
+        // O ritmo é controlado pelo FramePacer; com vsync o driver segura os 60 fps
+        window.setVerticalSyncEnabled(vsync);
+        window.setView(View(FloatRect(0, 0, MOBILE_RESOLUTION_X, MOBILE_RESOLUTION_Y)));
+        if (!canvas.create(MOBILE_RESOLUTION_X, MOBILE_RESOLUTION_Y)) {
+            cerr << "Erro ao criar textura de renderizacao" << endl;
+        }
+        canvas.setSmooth(true);
+        canvas.setView(resolution.view());
+        if (!staticLayer.create()) {
+            cerr << "Erro ao criar textura da camada estatica" << endl;
+        }
+        renderer = makeRenderBackend(rendererName, canvas, resolution);
+        if (!renderer) {
+            cerr << "Erro ao escolher renderizador: " << rendererName << endl;
+            renderer = makeRenderBackend("sfml", canvas, resolution);
+        }
+
+        // Carregar fontes
+        fontFile = assets.fontFile({"arial.ttf", "C:/Windows/Fonts/arial.ttf"});
+        if (fontFile->empty() || !font.loadFromMemory(fontFile->data(), fontFile->size())) {
+            cerr << "Erro ao carregar fonte" << endl;
+        }
+
+        // Português vem embutido em MESSAGES; os outros idiomas são catálogos compilados
+        if (language != "pt") {
+            catalog.load("assets/lang/" + language + ".cat");
+        }
+        window.setTitle(catalog.decode(MSG_GAME_TITLE));
+
+        // Configurar textos
+        setupTexts();
+
+        // Sprites dos resíduos; as texturas entram com a fase (bindTextures)
+        for (int i = 0; i < NONE; i++) {
+            Sprite sprite;
+            sprite.setScale(WASTE_SCALE, WASTE_SCALE); // Aumentado para mobile
+            wasteSprites.push_back(sprite);
+        }
+
+        // Carregar texturas dos power-ups
+        loadPowerUpTextures();
+
+        // Áreas de toque da simulação seguem o tamanho real das texturas,
+        // lido do cabeçalho: as das outras fases ainda não foram carregadas
+        sim->metrics = SpriteMetrics::loadFromImages();
+        sim->reset();
+
+        // Configurar lixeiras (e as texturas da primeira fase)
+        setupBins();
+
+        // Configurar barra de reputação
+        reputationBarBack.setSize(Vector2f(MOBILE_RESOLUTION_X * 0.3f, 25));
+        reputationBarBack.setFillColor(Color(50, 50, 50));
+        reputationBarBack.setPosition(MOBILE_RESOLUTION_X * 0.65f, 80);
+
+        reputationBar.setSize(Vector2f(MOBILE_RESOLUTION_X * 0.3f, 25));
+        reputationBar.setFillColor(Color(0, 200, 0));
+        reputationBar.setPosition(MOBILE_RESOLUTION_X * 0.65f, 80);
+
+        // Carregar sons
+        correctBuffer = assets.sound("assets/sounds/correct.wav");
+        wrongBuffer = assets.sound("assets/sounds/wrong.wav");
+        selectBuffer = assets.sound("assets/sounds/select.wav");
+
+        // Configurar música de fundo
+        if (!windowed) {
+            soundMuted = true;
+        } else if (!bgMusic.openFromFile("assets/sounds/menu.mp3")) {
+            cerr << "Erro ao carregar musica de fundo" << endl;
+        } else {
+            bgMusic.setLoop(true);
+            bgMusic.play();
+            bgMusic.setVolume(70); // Volume padrão
+        }
+
+        // Carregar texturas dos ícones de som
+        soundIcon.setTexture(textures.get(UI_TEXTURES[TEX_SOUND_ON]));
+        soundIcon.setScale(0.12f, 0.12f);
+        soundIcon.setPosition(MOBILE_RESOLUTION_X - 80, 30);
+
+        // Configurar barra de volume
+        volumeBar.setSize(Vector2f(150, 15));
+        volumeBar.setFillColor(Color(100, 100, 100));
+        volumeBar.setPosition(50, 30);
+
+        volumeFill.setSize(Vector2f(105, 15)); // 70% de volume inicial
+        volumeFill.setFillColor(Color(0, 200, 0));
+        volumeFill.setPosition(50, 30);
+
+        // Retratos: as texturas só entram no boss (bindTextures)
+        playerPortrait.setScale(0.05f, 0.05f);
+        if(!inBossIntro) {
+            bossPortrait.setScale(0.05f, 0.05f);
+        }
+
+        updateBackground(); // Começa na fase 1
+
+        // Botão de continuar (maior para touch)
+        continueButton.setSize(Vector2f(MOBILE_RESOLUTION_X * 0.6f, 100));
+        continueButton.setFillColor(Color(70, 130, 180));
+        continueButton.setPosition(MOBILE_RESOLUTION_X * 0.2f, MOBILE_RESOLUTION_Y * 0.7f);
+
+        TextRun& continueButtonText = texts[MSG_CONTINUE];
+        continueButtonText.position = Vector2f(
+            MOBILE_RESOLUTION_X / 2 - continueButtonText.bounds.width / 2,
+            MOBILE_RESOLUTION_Y * 0.7f + 35
+        );
+
+        levelInfoText.position = Vector2f(50, MOBILE_RESOLUTION_Y * 0.3f);
+
+        // Configurar painel e texto para história
+        storyPanel.setSize(Vector2f(MOBILE_RESOLUTION_X * 0.9f, MOBILE_RESOLUTION_Y * 0.7f));
+        storyPanel.setFillColor(Color(0, 0, 0, 180));
+        storyPanel.setOutlineColor(Color::White);
+        storyPanel.setOutlineThickness(2);
+        storyPanel.setPosition(MOBILE_RESOLUTION_X * 0.05f, MOBILE_RESOLUTION_Y * 0.15f);
+
+        texts[MSG_INTRO_STORY].position = Vector2f(MOBILE_RESOLUTION_X * 0.1f, MOBILE_RESOLUTION_Y * 0.2f);
+        texts[MSG_BOSS_STORY].position = texts[MSG_INTRO_STORY].position;
+        storyBg.setSize(Vector2f(MOBILE_RESOLUTION_X, MOBILE_RESOLUTION_Y));
+
+        // Carregar sons de vitória e derrota
+        victoryBuffer = assets.sound("assets/sounds/victory.mp3");
+        victorySound.setBuffer(*victoryBuffer);
+
+        defeatBuffer = assets.sound("assets/sounds/defeat.wav");
+        defeatSound.setBuffer(*defeatBuffer);
+
+        // Configurar barras de vida para o boss fight
+        playerLifeBarBack.setSize(Vector2f(MOBILE_RESOLUTION_X * 0.8f, 30));
+        playerLifeBarBack.setFillColor(Color(200, 200, 200)); // Fundo cinza
+        playerLifeBarBack.setOutlineColor(Color::Black);
+        playerLifeBarBack.setOutlineThickness(2);
+        playerLifeBarBack.setPosition(MOBILE_RESOLUTION_X * 0.1f, MOBILE_RESOLUTION_Y * 0.9f);
+
+        playerLifeBar.setSize(Vector2f(MOBILE_RESOLUTION_X * 0.8f, 30));
+        playerLifeBar.setFillColor(Color::Green);
+        playerLifeBar.setPosition(MOBILE_RESOLUTION_X * 0.1f, MOBILE_RESOLUTION_Y * 0.9f);
+
+        bossLifeBarBack.setSize(Vector2f(MOBILE_RESOLUTION_X * 0.8f, 30));
+        bossLifeBarBack.setFillColor(Color(200, 200, 200)); // Fundo cinza
+        bossLifeBarBack.setOutlineColor(Color::Black);
+        bossLifeBarBack.setOutlineThickness(2);
+        bossLifeBarBack.setPosition(MOBILE_RESOLUTION_X * 0.1f, 50);
+
+        bossLifeBar.setSize(Vector2f(MOBILE_RESOLUTION_X * 0.8f, 30));
+        bossLifeBar.setFillColor(Color::Red);
+        bossLifeBar.setPosition(MOBILE_RESOLUTION_X * 0.1f, 50);
+
+        applyVolume();
+        if (windowed) {
+            ui.start(campaign());
+        } else {
+            inStartScreen = false;
+        }
+    }
+
+    // Roteiro das telas na ordem em que acontecem: menu, história, fases,
+    // boss e derrota. Os flags in* dizem o que desenhar; só o roteiro os muda.
+    Script campaign() {
+        bool storyShown = false;
+        for (;;) {
+            inStartScreen = true;
+            co_await ui.wait(UI_START);
+            inStartScreen = false;
+            resetGame();
+            bgMusic.play();
+
+            // A história só aparece na primeira partida
+            if (!storyShown) {
+                storyShown = true;
+                inIntroStory = true;
+                co_await ui.wait(UI_TAP);
+                inIntroStory = false;
+            }
+
+            co_await playPhases();
+
+            // Derrota ou boss vencido: de volta ao menu
+            resetGame();
+            bgMusic.play();
+        }
+    }
+
+    Script playPhases() {
+        for (;;) {
+            co_await ui.wait(UI_ROUND_OVER);
+            if (sim->defeated) {
+                inDefeatScreen = true;
+                textures.prefetch(phaseTextures(COMMUNITY));
+                co_await ui.wait(UI_TAP);
+                co_return;
+            }
+
+            // --- Tela de transição: só o botão continuar libera ---
+            // Enquanto o jogador lê, a próxima fase (ou o menu, depois do boss)
+            // é decodificada em outra thread
+            inLevelTransition = true;
+            textures.prefetch(phaseTextures(sim->phase < BOSS ? sim->phase + 1 : COMMUNITY));
+            do {
+                co_await ui.wait(UI_TAP);
+            } while (!continueButton.getGlobalBounds().contains(lastTap));
+            inLevelTransition = false;
+            if (sim->phase == BOSS) {
+                co_return;
+            }
+
+            replay.add(*sim, ReplayInput::ADVANCE_PHASE);
+            sim->advancePhase();
+            setupBins();
+            updateBackground();
+            bgMusic.play();
+
+            // Introdução antes do boss
+            if (sim->phase == BOSS) {
+                inBossIntro = true;
+                co_await ui.wait(UI_TAP);
+                inBossIntro = false;
+                replay.add(*sim, ReplayInput::START_BOSS);
+                sim->startBossFight();
+            }
+        }
+    }
+
+    // Partida contra outro jogador: sem menu nem história, direto no tabuleiro
+    void startVersus(unique_ptr<VersusLink> link) {
+        versusLink = move(link);
+        ui.clear(); // O versus não tem menu nem fases
+        versus = make_unique<RollbackSession>();
+        versus->start(versusLink->localPlayer, versusLink->seed, sim->metrics);
+        sim = &versus->match.boards[versus->local]; // O rollback restaura por atribuição: o endereço não muda
+        inStartScreen = false;
+        inIntroStory = false;
+        setupBins();
+        updateBackground();
+    }
+
+    void setupTexts() {
+        glyphCache.prewarmAll(font);
+        // Outros idiomas podem ter letras fora do ASCII e dos acentos do português
+        for (int id = 0; id < MSG_COUNT; ++id) {
+            String text = catalog.decode(static_cast<MessageId>(id));
+            for (const TextStyle& style : GAME_TEXT_STYLES) {
+                glyphCache.prewarm(font, style, text);
+            }
+        }
+
+        string hudCharset = HUD_SYMBOLS;
+        for (int id = MSG_HUD_SCORE; id <= MSG_HUD_RIVAL; ++id) {
+            for (const char* c = catalog.text(static_cast<MessageId>(id)); *c; ++c) {
+                if (hudCharset.find(*c) == string::npos) {
+                    hudCharset += *c;
+                }
+            }
+        }
+        if (!hudAtlas.build(font, hudCharset)) {
+            cerr << "Erro ao criar atlas de glifos do HUD" << endl;
+        }
+        hud.atlas = &hudAtlas;
+
+        // Textos fixos: o layout sai pronto daqui, no tamanho em que aparecem
+        for (int id = 0; id < MSG_COUNT; ++id) {
+            const MessageInfo& info = MESSAGES[id];
+            if (info.size > 0 && strchr(info.text, '%') == nullptr) {
+                texts[id].shape(font, catalog.decode(static_cast<MessageId>(id)), info.size, info.bold);
+            }
+        }
+
+        phaseText.position = Vector2f(20, 70);
+        messageText.position = Vector2f(MOBILE_RESOLUTION_X / 2, MOBILE_RESOLUTION_Y / 2);
+
+        // Configurações para a tela inicial
+        TextRun& gameTitle = texts[MSG_GAME_TITLE];
+        gameTitle.position = Vector2f(MOBILE_RESOLUTION_X / 2 - gameTitle.bounds.width / 2, MOBILE_RESOLUTION_Y * 0.2f);
+
+        startButton.setSize(Vector2f(MOBILE_RESOLUTION_X * 0.6f, 120));
+        startButton.setFillColor(Color(70, 130, 180));
+        startButton.setPosition(MOBILE_RESOLUTION_X * 0.2f, MOBILE_RESOLUTION_Y * 0.5f);
+
+        TextRun& startButtonText = texts[MSG_START];
+        startButtonText.position = Vector2f(
+            MOBILE_RESOLUTION_X / 2 - startButtonText.bounds.width / 2,
+            MOBILE_RESOLUTION_Y * 0.5f + 40
+        );
+
+        overlay.setSize(Vector2f(MOBILE_RESOLUTION_X, MOBILE_RESOLUTION_Y));
+
+        texts[MSG_VOLUME].position = Vector2f(50, 10);
+
+        defeatText.assign(texts[MSG_DEFEAT]);
+        defeatText.color = Color::Red;
+        defeatText.origin = Vector2f(defeatText.bounds.width / 2, 0);
+        defeatText.position = Vector2f(MOBILE_RESOLUTION_X / 2, MOBILE_RESOLUTION_Y * 0.3f);
+    }
+
+    // Texto formatado na hora (com números), no tamanho e peso da mensagem style
+    void shapeText(TextRun& run, MessageId style, const char* text) {
+        String decoded = String::fromUtf8(text, text + strlen(text));
+        glyphCache.track(decoded, MESSAGES[style].size, MESSAGES[style].bold);
+        run.shape(font, decoded, MESSAGES[style].size, MESSAGES[style].bold);
+    }
+
+    const char* phaseName(int phase) const {
+        return catalog.text(static_cast<MessageId>(MSG_PHASE_COMMUNITY + phase));
+    }
+
+    // Mensagens fixas copiam os vértices prontos; só as com número são montadas aqui
+    void showMessage(MessageId id, int value, Color color) {
+        const char* format = catalog.text(id);
+        if (id == MSG_PHASE_LABEL) {
+            shapeText(messageText, id, frameArena.format(format, phaseName(value)).c_str());
+        } else if (strchr(MESSAGES[id].text, '%') != nullptr) {
+            shapeText(messageText, id, frameArena.format(format, value).c_str());
+        } else {
+            messageText.assign(texts[id]);
+        }
+        messageText.color = color;
+        messageText.origin = Vector2f(messageText.bounds.width / 2, 0);
+        messageText.position = Vector2f(MOBILE_RESOLUTION_X / 2, MOBILE_RESOLUTION_Y / 2);
+        uiTimers.cancel(messageTimer);
+        messageTimer = uiTimers.schedule(TimerWheel::ticksFor(1.5f), MESSAGE_CLEAR);
+        messageShownTick = uiTimers.now();
+    }
+
+    // Sem o arquivo, textura cor de rosa para debug
+    static TextureSpec wasteTexture(int type) {
+        return TextureSpec{WASTE_TEXTURE_FILES[type], Vector2u(50, 50), Color(255, 0, 255)};
+    }
+
+    static TextureSpec binTexture(int type) {
+        return TextureSpec{BIN_TEXTURE_FILES[type], Vector2u(70, 100), Color(0, 150, 0)};
+    }
+
+    static TextureSpec backgroundTexture(int phase) {
+        return TextureSpec{PHASE_CONFIGS[phase].background, Vector2u(50, 50), Color(255, 0, 255)};
+    }
+
+    // Tudo que as telas da fase desenham; o resto pode sair da memória de vídeo
+    static vector<TextureSpec> phaseTextures(int phase) {
+        const PhaseConfig& config = PHASE_CONFIGS[phase];
+        vector<TextureSpec> set = {backgroundTexture(phase)};
+        for (int i = 0; i < config.wasteTypeCount; i++) {
+            set.push_back(wasteTexture(i));
+        }
+        for (int i = 0; i < config.binCount; i++) {
+            set.push_back(binTexture(config.bins[i]));
+        }
+        for (int i = TEX_SOUND_ON; i <= TEX_BOSS_DAMAGE; i++) {
+            set.push_back(UI_TEXTURES[i]);
+        }
+        if (phase == BOSS) {
+            set.push_back(UI_TEXTURES[TEX_PLAYER_PORTRAIT]);
+            set.push_back(UI_TEXTURES[TEX_BOSS_PORTRAIT]);
+        }
+        return set;
+    }
+
+    // Troca o conjunto de trabalho para a fase atual e aponta os sprites
+    // para ele; sprites de fora do conjunto não são desenhados nesta fase
+    void bindTextures() {
+        textures.use(phaseTextures(sim->phase));
+        for (int i = 0; i < PHASE_CONFIGS[sim->phase].wasteTypeCount; i++) {
+            wasteSprites[i].setTexture(textures.get(wasteTexture(i)), true);
+        }
+        if (sim->phase == BOSS) {
+            playerPortrait.setTexture(textures.get(UI_TEXTURES[TEX_PLAYER_PORTRAIT]), true);
+            bossPortrait.setTexture(textures.get(UI_TEXTURES[TEX_BOSS_PORTRAIT]), true);
+        }
+    }
+
+    // Os ícones dos power-ups aparecem em todas as fases: nunca são despejados
+    void loadPowerUpTextures() {
+        // Centralizar cada sprite no brilho
+        for (int i = TEX_COMBO_BOOST; i <= TEX_BOSS_DAMAGE; i++) {
+            Sprite sprite;
+            sprite.setTexture(textures.get(UI_TEXTURES[i]));
+            sprite.setScale(0.12f, 0.12f); // Aumentado para mobile
+            FloatRect spriteBounds = sprite.getLocalBounds();
+            sprite.setOrigin(spriteBounds.width / 2, spriteBounds.height / 2);
+            powerUpSprites.push_back(sprite);
+        }
+
+        powerUpBuffer = assets.sound("assets/sounds/powerup.wav");
+        powerUpSound.setBuffer(*powerUpBuffer);
+    }
+
+    // Monta sprites e nomes das lixeiras a partir do layout da simulação
+    void setupBins() {
+        bindTextures();
+        staticLayer.invalidate();
+        bins.clear();
+        binLabels.clear(); // Limpa os textos antigos
+
+        for (size_t i = 0; i < sim->binTypes.size(); i++) {
+            WasteType type = sim->binTypes[i];
+            Vector2f position = sim->binPositions[i];
+
+            Sprite bin;
+            bin.setTexture(textures.get(binTexture(type)));
+            bin.setScale(BIN_SCALE, BIN_SCALE); // Aumentado para mobile
+            bin.setPosition(position);
+            bins.push_back(bin);
+
+            // Nome da lixeira, já montado em setupTexts
+            TextRun label = texts[MSG_BIN_PAPER + static_cast<int>(type)];
+            label.position = Vector2f(position.x + (BIN_WIDTH * 0.1f), position.y + 100); // Ajuste em Y também
+            binLabels.push_back(label);
+        }
+    }
+
+    // Toca sons, solta faíscas e troca de tela conforme o que aconteceu na simulação
+    void processSimEvents() {
+        AllocScope scope(ALLOC_AUDIO);
+        particles.emit(sim->events);
+        bool roundOver = false;
+        for (const auto& event : sim->events) {
+            switch (event.type) {
+                case SimEvent::WASTE_SELECTED:
+                    sound.setBuffer(*selectBuffer);
+                    sound.play();
+                    break;
+
+                case SimEvent::CORRECT_SORT:
+                    sound.setBuffer(*correctBuffer);
+                    sound.play();
+                    break;
+
+                case SimEvent::MAGNET_COLLECTED:
+                    sound.setBuffer(*correctBuffer);
+                    sound.play();
+                    break;
+
+                case SimEvent::WRONG_SORT:
+                    sound.setBuffer(*wrongBuffer);
+                    sound.play();
+                    break;
+
+                case SimEvent::WASTE_MISSED:
+                    if (!sim->inBossFight) {
+                        sound.setBuffer(*wrongBuffer);
+                        sound.play();
+                    }
+                    break;
+
+                case SimEvent::BOSS_HIT:
+                    powerUpSound.play();
+                    break;
+
+                case SimEvent::POWERUP_USED:
+                    powerUpSound.play();
+                    break;
+
+                case SimEvent::MESSAGE:
+                    showMessage(event.message, event.value, event.color);
+                    break;
+
+                case SimEvent::PHASE_COMPLETE:
+                    roundOver = true;
+                    if (sim->phase == COMMUNITY || sim->phase == INDUSTRIAL) {
+                        shapeText(levelInfoText, MSG_PHASE_COMPLETE, frameArena.format(catalog.text(MSG_PHASE_COMPLETE),
+                                                                                       sim->phase + 1, sim->score, sim->reputation).c_str());
+                    } else if (sim->phase == MEGACENTER) {
+                        levelInfoText.assign(texts[MSG_BOSS_AHEAD]);
+                    } else {
+                        levelInfoText.assign(texts[MSG_BOSS_DEFEATED]);
+                    }
+                    bgMusic.pause();
+                    victorySound.play();
+                    break;
+
+                case SimEvent::DEFEAT:
+                    roundOver = true;
+                    if (sim->phase == BOSS) {
+                        showMessage(MSG_BOSS_LOST, 0, Color::Red);
+                    } else {
+                        bgMusic.pause();
+                        defeatSound.play();
+                    }
+                    break;
+
+                default:
+                    break;
+            }
+        }
+        sim->events.clear();
+        if (roundOver) {
+            ui.signal(UI_ROUND_OVER);
+        }
+    }
+
+    // Mouse (botão esquerdo) e toque no mesmo formato
+    bool toPointerEvent(const Event& event, PointerEvent& pointer) {
+        Vector2i pixel;
+        switch (event.type) {
+            case Event::MouseButtonPressed:
+            case Event::MouseButtonReleased:
+                if (event.mouseButton.button != Mouse::Left) {
+                    return false;
+                }
+                pointer.type = (event.type == Event::MouseButtonPressed) ? PointerEvent::DOWN : PointerEvent::UP;
+                pixel = Vector2i(event.mouseButton.x, event.mouseButton.y);
+                break;
+            case Event::MouseMoved:
+                pointer.type = PointerEvent::MOVE;
+                pixel = Vector2i(event.mouseMove.x, event.mouseMove.y);
+                break;
+            case Event::TouchBegan:
+            case Event::TouchMoved:
+            case Event::TouchEnded:
+                pointer.type = (event.type == Event::TouchBegan) ? PointerEvent::DOWN :
+                               (event.type == Event::TouchMoved) ? PointerEvent::MOVE : PointerEvent::UP;
+                pixel = Vector2i(event.touch.x, event.touch.y);
+                break;
+            default:
+                return false;
+        }
+        pointer.position = window.mapPixelToCoords(pixel);
+        pointer.timestamp = pacer.now();
+        return true;
+    }
+
+    // Movimentos seguidos viram um só: o tick usa apenas a última posição
+    void queuePointer(const PointerEvent& pointer) {
+        if (pointer.type == PointerEvent::MOVE && !pendingInput.empty() &&
+            pendingInput.back().type == PointerEvent::MOVE) {
+            pendingInput.back() = pointer;
+        } else {
+            pendingInput.push_back(pointer);
+        }
+    }
+
+    bool inGameplay() const {
+        return !inStartScreen && !inLevelTransition && !inDefeatScreen && !inIntroStory && !inBossIntro;
+    }
+
+    // Ícone e volumes conforme soundMuted
+    void applyVolume() {
+        float music = soundMuted ? 0.0f : 70.0f, effects = soundMuted ? 0.0f : 100.0f;
+        bgMusic.setVolume(music);
+        sound.setVolume(effects);
+        victorySound.setVolume(effects);
+        defeatSound.setVolume(effects);
+        powerUpSound.setVolume(effects);
+        soundIcon.setTexture(textures.get(UI_TEXTURES[soundMuted ? TEX_SOUND_OFF : TEX_SOUND_ON]));
+    }
+
+    void applyPendingInput() {
+        AllocScope scope(ALLOC_INPUT);
+        for (const PointerEvent& pointer : pendingInput) {
+            // Toques e arrastes mudam a tela; movimentos soltos não
+            bool dragging = volumeDragging || sim->dragging;
+            if (pointer.type == PointerEvent::DOWN || (pointer.type == PointerEvent::MOVE && dragging)) {
+                shownInput.push_back(pointer.timestamp);
+            }
+            handlePointer(pointer);
+        }
+        pendingInput.clear();
+    }
+
+    void handlePointer(const PointerEvent& pointer) {
+        // Controle de som na tela inicial
+        if (inStartScreen) {
+            if (pointer.type == PointerEvent::DOWN) {
+                Vector2f touchPos = pointer.position;
+                if (soundIcon.getGlobalBounds().contains(touchPos)) {
+                    soundMuted = !soundMuted;
+                    applyVolume();
+                }
+                // Controle de volume
+                else if (volumeBar.getGlobalBounds().contains(touchPos)) {
+                    float volumePercent = (touchPos.x - volumeBar.getPosition().x) / volumeBar.getSize().x * 100.0f;
+                    volumePercent = max(0.0f, min(100.0f, volumePercent));
+                    volumeFill.setSize(Vector2f(volumePercent * volumeBar.getSize().x / 100.0f, 15));
+                    bgMusic.setVolume(volumePercent);
+                    volumeDragging = true;
+                }
+                else if (startButton.getGlobalBounds().contains(touchPos)) {
+                    ui.signal(UI_START);
+                }
+            }
+            else if (pointer.type == PointerEvent::MOVE && volumeDragging) {
+                Vector2f touchPos = pointer.position;
+                float volumePercent = (touchPos.x - volumeBar.getPosition().x) / volumeBar.getSize().x * 100.0f;
+                volumePercent = max(0.0f, min(100.0f, volumePercent));
+                volumeFill.setSize(Vector2f(volumePercent * volumeBar.getSize().x / 100.0f, 15));
+                bgMusic.setVolume(volumePercent);
+            }
+            else if (pointer.type == PointerEvent::UP) {
+                volumeDragging = false;
+            }
+            return;
+        }
+
+        // História, introdução do boss, transição e derrota: o toque só avisa o roteiro
+        if (!inGameplay()) {
+            if (pointer.type == PointerEvent::DOWN) {
+                if (inDefeatScreen && versusLink) {
+                    window.close(); // No versus não há menu para onde voltar
+                    return;
+                }
+                lastTap = pointer.position;
+                ui.signal(UI_TAP);
+            }
+            return;
+        }
+
+        if (versusLink) {
+            // No versus o toque entra num tick futuro, o mesmo nas duas máquinas
+            ReplayInput::Type type = (pointer.type == PointerEvent::DOWN) ? ReplayInput::DOWN :
+                                     (pointer.type == PointerEvent::MOVE) ? ReplayInput::MOVE : ReplayInput::UP;
+            versusInput.add(type, pointer.position);
+        } else {
+            // Primeiro verifica power-ups, depois lixos e lixeiras; arrastar até a lixeira também separa
+            if (pointer.type == PointerEvent::DOWN) {
+                replay.add(*sim, ReplayInput::DOWN, pointer.position);
+                sim->pointerDown(pointer.position);
+            } else if (pointer.type == PointerEvent::MOVE) {
+                replay.add(*sim, ReplayInput::MOVE, pointer.position);
+                sim->pointerMove(pointer.position);
+            } else {
+                replay.add(*sim, ReplayInput::UP, pointer.position);
+                sim->pointerUp(pointer.position);
+            }
+            processSimEvents();
+        }
+    }
+
+    void update() {
+        AllocScope scope(ALLOC_UPDATE);
+        applyPendingInput();
+        if (versusLink) {
+            stepVersus();
+        } else {
+            sim->tick();
+        }
+        afterTick();
+    }
+
+    // Eventos, faíscas, textos e mensagens depois de cada tick da simulação
+    void afterTick() {
+        processSimEvents();
+        particles.update();
+
+        // Atualizar textos (os números são emitidos em renderHud)
+        if (shownPhase != sim->phase) {
+            shownPhase = sim->phase;
+            shapeText(phaseText, MSG_PHASE_LABEL, frameArena.format(catalog.text(MSG_PHASE_LABEL), phaseName(sim->phase)).c_str());
+        }
+
+        reputationBar.setSize(Vector2f(MOBILE_RESOLUTION_X * 0.3f * sim->reputation / 100.0f, 25));
+
+        // Atualizar mensagens temporárias e animação do texto de power-up
+        uiTimers.advance([this](int kind, unsigned) {
+            if (kind == MESSAGE_CLEAR) {
+                messageText.clear(); // Limpa após 1.5 segundos
+            }
+        });
+        if (uiTimers.pending(messageTimer)) {
+            float elapsed = (uiTimers.now() - messageShownTick) * SIM_DT;
+            // Fade out e movimento para cima
+            if (elapsed > 0.5f) {
+                float alpha = max(0.0f, 255.0f - (elapsed - 0.5f) * 255.0f);
+                messageText.color.a = static_cast<Uint8>(alpha);
+                messageText.position = Vector2f(MOBILE_RESOLUTION_X / 2, MOBILE_RESOLUTION_Y / 2 - (elapsed - 0.5f) * 30.0f); // Sobe lentamente
+            }
+        }
+    }
+
+    // Um tick do versus: corrige as previsões e avança se o adversário não ficou para trás
+    void stepVersus() {
+        if (!versus || inDefeatScreen) return; // Resultado já mostrado num tick anterior deste frame
+        int phase = sim->phase;
+        versusLink->receive(*versus);
+        versus->rollback();
+        bool advanced = versus->canAdvance();
+        if (advanced) {
+            versus->advance(versusInput);
+            versusInput = TickInput();
+        }
+        versusLink->send(*versus);
+
+        // Os eventos são só a saída do último tick (step limpa antes de
+        // simular), então mexer neles não muda a partida
+        if (!advanced) {
+            sim->events.clear(); // Já tratados no tick em que aconteceram
+        }
+        // A derrota pode ser desfeita por um rollback; a tela final espera o resultado confirmado
+        sim->events.erase(remove_if(sim->events.begin(), sim->events.end(),
+            [](const SimEvent& e) {
+                return e.type == SimEvent::DEFEAT;
+            }), sim->events.end());
+        if (sim->phase != phase) {
+            setupBins();
+            updateBackground();
+        }
+
+        if (versus->desynced) {
+            showVersusResult(MSG_VERSUS_DESYNC, false);
+        } else if (versus->finished()) {
+            int winner = versus->match.winner;
+            showVersusResult(winner == 2 ? MSG_VERSUS_DRAW : winner == versus->local ? MSG_VERSUS_WIN : MSG_VERSUS_LOSS,
+                             winner == versus->local);
+        } else if (versusLink->timedOut()) {
+            showVersusResult(MSG_VERSUS_DISCONNECTED, false);
+        }
+    }
+
+    void showVersusResult(MessageId result, bool won) {
+        const Simulation& rival = versus->match.boards[versus->remote()];
+        shapeText(defeatText, MSG_VERSUS_RESULT, frameArena.format(catalog.text(MSG_VERSUS_RESULT), catalog.text(result),
+                                                                   sim->score, rival.score).c_str());
+        defeatText.color = won ? Color::Green : Color::Red;
+        defeatText.origin = Vector2f(defeatText.bounds.width / 2, 0);
+        inDefeatScreen = true;
+        bgMusic.pause();
+        if (won) {
+            victorySound.play();
+        } else {
+            defeatSound.play();
+        }
+    }
+
+    // --- Adicione uma função para atualizar o background conforme a fase ---
+    void updateBackground() {
+        staticLayer.invalidate();
+        bgSprite.setTexture(textures.get(backgroundTexture(sim->phase)), true);
+
+        // Ajusta o tamanho do background para preencher a janela
+        bgSprite.setScale(
+            static_cast<float>(MOBILE_RESOLUTION_X) / bgSprite.getLocalBounds().width,
+            static_cast<float>(MOBILE_RESOLUTION_Y) / bgSprite.getLocalBounds().height
+        );
+    }
+
+    // Mostra o frame do backend na janela e ajusta a escala
+    void presentFrame() {
+        window.clear();
+        renderer->present(window);
+        float workSeconds = workClock.getElapsedTime().asSeconds();
+
+        pacer.setRate(targetFrameRate());
+        if (!vsync || pacer.rate() < SIM_TICK_RATE) {
+            pacer.wait();
+        }
+        window.display();
+        pacer.markPresented();
+        AllocTracker::endFrame();
+        Int64 shownAt = pacer.now();
+        for (Int64 timestamp : shownInput) {
+            inputLatency.add(shownAt - timestamp);
+        }
+        shownInput.clear();
+
+        float budget = 1.0f / pacer.rate();
+        if (resolution.update(frameClock.restart().asSeconds(), workSeconds, budget)) {
+            canvas.setView(resolution.view());
+        }
+        workClock.restart();
+    }
+
+    // Telas paradas e partida sem nada em movimento não precisam de 60 fps
+    int targetFrameRate() {
+        if (inputClock.getElapsedTime().asSeconds() < 0.5f) {
+            return 60;
+        }
+        if (!inGameplay()) {
+            return 20;
+        }
+        bool idle = sim->activeWastes.empty() && sim->activePowerUps.empty() &&
+                    particles.count == 0 && messageText.empty() &&
+                    !sim->specialEvent && !sim->magnetActive &&
+                    !sim->timers.pending(sim->timeFreezeTimer) && !sim->timers.pending(sim->comboBoostTimer);
+        return idle ? 30 : 60;
+    }
+
+    void drawText(const TextRun& text) {
+        text.draw(*renderer, textVertices);
+    }
+
+    void renderDefeatScreen() {
+        renderer->clear(Color(30, 0, 0));
+        // Fundo escuro
+        overlay.setFillColor(Color(0, 0, 0, 200));
+        renderer->draw(bgSprite);
+        renderer->draw(overlay);
+
+        drawText(defeatText);
+    }
+
+    // --- Adicione uma função para resetar o jogo ---
+    void resetGame() {
+        saveReplay();
+        // Semente nova a cada partida; é ela que o replay guarda
+        unsigned seed = sim->rng();
+        sim->rng.seed(seed);
+        sim->reset();
+        replay.begin(seed);
+        inventory.clear();
+        particles.clear();
+        inLevelTransition = false;
+        inDefeatScreen = false;
+        inBossIntro = false;
+        setupBins();
+        updateBackground();
+    }
+
+    // Com --record, a partida que acabou de terminar vai para o arquivo
+    void saveReplay() {
+        if (!replayFile.empty() && !replay.inputs.empty()) {
+            replay.save(replayFile);
+        }
+    }
+
+    // Recompõe a camada estática só quando a fase (ou a janela) muda
+    void renderStaticLayer() {
+        if (staticLayer.needsRebuild(sim->phase)) {
+            updateBackground();
+            staticLayer.rebuild(sim->phase, [this](RenderTarget& target) {
+                target.draw(bgSprite);
+                for (const auto& bin : bins) {
+                    target.draw(bin);
+                }
+                for (const auto& label : binLabels) {
+                    label.draw(target);
+                }
+            });
+            renderer->textureChanged(&staticLayer.texture.getTexture());
+        }
+        renderer->draw(staticLayer.sprite);
+    }
+
+    void renderWastes() {
+        for (const auto& waste : sim->activeWastes) {
+            Sprite& sprite = wasteSprites[waste.type];
+            sprite.setPosition(waste.position);
+            sprite.setColor(waste.selected ? Color(255, 255, 0) : Color::White);
+            renderer->draw(sprite);
+        }
+    }
+
+    void renderPowerUps() {
+        // Piscar (alternar transparência)
+        powerUpGlow.setTick(sim->timers.now());
+        for (const auto& powerUp : sim->activePowerUps) {
+            powerUpGlow.draw(*renderer, powerUp.position);
+
+            Sprite& sprite = powerUpSprites[powerUp.type];
+            sprite.setPosition(powerUp.position);
+            renderer->draw(sprite);
+        }
+    }
+
+    // Ícone do efeito com a barra de tempo restante ao lado
+    void renderEffect(PowerUp::Type type, float x, float y, float ratio, Color barColor) {
+        effectIcon.setTexture(textures.get(UI_TEXTURES[TEX_COMBO_BOOST + static_cast<int>(type)]), true);
+        effectIcon.setScale(0.08f, 0.08f);
+        effectIcon.setPosition(x, y);
+        renderer->draw(effectIcon);
+
+        // Barra de tempo
+        effectBar.setSize(Vector2f(60, 8));
+        effectBar.setFillColor(Color(50,50,50));
+        effectBar.setPosition(x + 70, y + 30);
+        renderer->draw(effectBar);
+
+        effectBar.setSize(Vector2f(60 * ratio, 8));
+        effectBar.setFillColor(barColor);
+        renderer->draw(effectBar);
+    }
+
+    void renderActivePowerUpEffects() {
+        float x = MOBILE_RESOLUTION_X * 0.8f;
+        float y = 150;
+        float spacing = 60;
+
+        // Time Freeze
+        if (sim->timers.pending(sim->timeFreezeTimer)) {
+            renderEffect(PowerUp::TIME_FREEZE, x, y, sim->remainingSeconds(sim->timeFreezeTimer) / 5.0f, Color::Cyan);
+            y += spacing;
+        }
+
+        // Combo Boost
+        if (sim->timers.pending(sim->comboBoostTimer)) {
+            renderEffect(PowerUp::COMBO_BOOST, x, y, sim->remainingSeconds(sim->comboBoostTimer) / 10.0f, Color::Yellow);
+
+            // Multiplicador
+            hud.print(HUD_SMALL, Vector2f(x + 140, y), Color::Yellow, "x%d", static_cast<int>(sim->comboBoostMultiplier));
+
+            y += spacing;
+        }
+
+        // Magnet
+        if (sim->magnetActive) {
+            renderEffect(PowerUp::MAGNET, x, y, sim->remainingSeconds(sim->magnetTimer) / 5.0f, Color::Green);
+            y += spacing;
+        }
+
+        // Shield
+        if (sim->shieldCount > 0) {
+            effectIcon.setTexture(textures.get(UI_TEXTURES[TEX_SHIELD]), true);
+            effectIcon.setScale(0.08f, 0.08f);
+            effectIcon.setPosition(x, y);
+            renderer->draw(effectIcon);
+
+            // Contador
+            hud.print(HUD_LARGE_BOLD, Vector2f(x + 60, y - 10), Color::Blue, "%d", sim->shieldCount);
+        }
+    }
+
+    void renderLifeBars() {
+        if (sim->inBossFight) {
+            // Atualiza tamanho das barras
+            playerLifeBar.setSize(Vector2f(MOBILE_RESOLUTION_X * 0.8f * sim->playerLife / 100.0f, 30));
+            bossLifeBar.setSize(Vector2f(MOBILE_RESOLUTION_X * 0.8f * sim->bossLife / 100.0f, 30));
+
+            // Desenha fundos
+            renderer->draw(playerLifeBarBack);
+            renderer->draw(bossLifeBarBack);
+
+            // Desenha barras de vida
+            renderer->draw(bossLifeBar);
+            renderer->draw(playerLifeBar);
+
+            // Desenha retratos ao lado das barras
+            bossPortrait.setPosition(30, 40);
+            renderer->draw(bossPortrait);
+
+            playerPortrait.setPosition(30, MOBILE_RESOLUTION_Y * 0.9f - 15);
+            renderer->draw(playerPortrait);
+
+            // Desenha textos de vida
+            hud.print(HUD_SMALL_BOLD, Vector2f(MOBILE_RESOLUTION_X - 100, 55), Color::White, "%d%%", sim->bossLife);
+            hud.print(HUD_SMALL_BOLD, Vector2f(MOBILE_RESOLUTION_X - 100, MOBILE_RESOLUTION_Y * 0.9f), Color::White, "%d%%", sim->playerLife);
+        }
+    }
+
+    // Pontuação, combo e reputação, emitidos como quads do atlas
+    void renderHud() {
+        char score[32], combo[32];
+        snprintf(score, sizeof(score), catalog.text(MSG_HUD_SCORE), sim->score);
+        snprintf(combo, sizeof(combo), catalog.text(MSG_HUD_COMBO), sim->combo);
+
+        if (sim->inBossFight) {
+            // Na fase do boss, os textos vão para o canto superior direito
+            float rightMargin = 20.0f; // 20 pixels da borda direita
+            hud.add(HUD_LARGE, score, Vector2f(MOBILE_RESOLUTION_X - hudAtlas.measure(HUD_LARGE, score) - rightMargin, 40), Color::White);
+            hud.add(HUD_LARGE, combo, Vector2f(MOBILE_RESOLUTION_X - hudAtlas.measure(HUD_LARGE, combo) - rightMargin, 90), Color::White);
+        } else {
+            hud.add(HUD_LARGE, score, Vector2f(20, 20), Color::White);
+            hud.add(HUD_LARGE, combo, Vector2f(20, 120), Color::White);
+            // Não mostrar reputação na fase do boss
+            hud.print(HUD_MEDIUM, Vector2f(MOBILE_RESOLUTION_X * 0.65f, 40), Color::White, catalog.text(MSG_HUD_REPUTATION), sim->reputation);
+        }
+
+        if (versus) {
+            const Simulation& rival = versus->match.boards[versus->remote()];
+            hud.print(HUD_MEDIUM, Vector2f(MOBILE_RESOLUTION_X * 0.65f, 120), Color(255, 200, 120),
+                      catalog.text(MSG_HUD_RIVAL), rival.score, rival.reputation);
+        }
+
+        if (sim->comboBoostMultiplier > 1.0f) {
+            hud.print(HUD_LARGE_BOLD, Vector2f(150 + hudAtlas.measure(HUD_LARGE, combo), 120), Color::Yellow, "x%.1f", sim->comboBoostMultiplier);
+        }
+    }
+
+    // A tela do estado atual, no backend. run() apresenta na janela; sem
+    // janela, quem chamou lê o quadro do backend
+    void renderScreen() {
+        renderer->clear(Color(30, 70, 40));
+
+        if (inStartScreen) {
+            bgSprite.setTexture(textures.get(backgroundTexture(COMMUNITY)), true);
+            bgSprite.setScale(
+                static_cast<float>(MOBILE_RESOLUTION_X) / bgSprite.getLocalBounds().width,
+                static_cast<float>(MOBILE_RESOLUTION_Y) / bgSprite.getLocalBounds().height
+            );
+            renderer->draw(bgSprite);
+
+            overlay.setFillColor(Color(0, 0, 0, 100));
+            renderer->draw(overlay);
+
+            drawText(texts[MSG_GAME_TITLE]);
+            renderer->draw(startButton);
+            drawText(texts[MSG_START]);
+            renderer->draw(soundIcon);
+            
+            // Desenhar barra de volume
+            renderer->draw(volumeBar);
+            renderer->draw(volumeFill);
+            
+            // Texto de volume
+            drawText(texts[MSG_VOLUME]);
+            
+            return;
+        }
+
+        // --- Tela de introdução da história ---
+        if (inIntroStory) {
+            renderer->clear(Color(40, 40, 60));
+            
+            // Desenhar fundo temático
+            storyBg.setFillColor(Color(30, 50, 70));
+            renderer->draw(storyBg);
+            
+            // Painel para texto
+            storyPanel.setFillColor(Color(0, 0, 0, 180));
+            renderer->draw(storyPanel);
+            
+            // Texto da história
+            drawText(texts[MSG_INTRO_STORY]);
+            
+            return;
+        }
+        
+        // --- Tela de introdução do boss ---
+        if (inBossIntro) {
+            renderer->clear(Color(70, 30, 30));
+            
+            // Desenhar fundo temático
+            storyBg.setFillColor(Color(60, 30, 40));
+            renderer->draw(storyBg);
+            
+            // Painel para texto
+            storyPanel.setFillColor(Color(0, 0, 0, 180));
+            renderer->draw(storyPanel);
+            
+            // Texto da história do boss
+            drawText(texts[MSG_BOSS_STORY]);
+            
+            // Desenhar retrato do boss
+            bossPortrait.setPosition(MOBILE_RESOLUTION_X - 100, MOBILE_RESOLUTION_Y * 0.6f);
+            bossPortrait.setScale(0.05f, 0.05f);
+            renderer->draw(bossPortrait);
+            
+            return;
+        }
+
+        // --- Tela de derrota ---
+        if (inDefeatScreen) {
+            renderDefeatScreen();
+            return;
+        }
+
+        // --- Tela de transição de fase ---
+        if (inLevelTransition) {
+            renderer->draw(bgSprite);
+            drawText(levelInfoText);
+            renderer->draw(continueButton);
+            drawText(texts[MSG_CONTINUE]);
+            return;
+        }
+
+        renderStaticLayer();
+        renderWastes();
+        renderPowerUps();
+        particles.render(*renderer);
+        
+        // Reposicionar a fase no canto superior direito durante o boss
+        if (sim->inBossFight) {
+            Vector2f originalPhasePos = phaseText.position;
+            float rightMargin = 20.0f; // 20 pixels da borda direita
+            phaseText.position = Vector2f(MOBILE_RESOLUTION_X - phaseText.bounds.width - rightMargin, 140);
+            drawText(phaseText);
+            phaseText.position = originalPhasePos;
+        } else {
+            drawText(phaseText);
+        }
+        
+        // Não mostrar reputação na fase do boss
+        if (!sim->inBossFight) {
+            renderer->draw(reputationBarBack);
+            renderer->draw(reputationBar);
+        }
+        renderHud();
+
+        // Desenhar efeitos visuais para power-ups ativos
+        renderActivePowerUpEffects();
+
+        if (!messageText.empty()) {
+            drawText(messageText);
+        }
+        
+        if (sim->inBossFight) {
+            renderLifeBars();
+        }
+
+        // Todos os números do HUD num único draw
+        hud.draw(*renderer);
+    }
+
+    // --- Sem janela ---
+    // A partida é dirigida de fora (ReplayPlayer, SimPlayer) e desenhada
+    // pelas mesmas funções do run(). O roteiro de telas não roda: a tela
+    // mostrada sai do estado da simulação.
+    void setRenderer(unique_ptr<RenderBackend> backend) {
+        renderer = move(backend);
+    }
+
+    // start prepara a simulação (semente, reset); lixeiras e fundo seguem
+    template <class Start>
+    void startOffscreen(Start start) {
+        start(*sim);
+        particles.clear();
+        messageText.clear();
+        setupBins();
+        updateBackground();
+        syncScreens();
+    }
+
+    // step avança a simulação um tick; false quando a partida acabou
+    template <class Step>
+    bool tickOffscreen(Step step) {
+        int phase = sim->phase;
+        bool playing = step(*sim);
+        if (sim->phase != phase) {
+            setupBins();
+            updateBackground();
+        }
+        afterTick();
+        syncScreens();
+        return playing;
+    }
+
+    void renderOffscreen() {
+        frameArena.reset();
+        renderer->beginFrame();
+        renderScreen();
+    }
+
+    // Sem GPU, o backend de software lê as texturas da fase dos arquivos
+    // (páginas de fonte e camada estática só existem na GPU e ficam de fora)
+    void registerTextureImages(SoftwareBackend& software) {
+        textures.forEachResident([&](const string& file, const Texture& texture) {
+            Image image;
+            if (image.loadFromFile(file)) {
+                software.registerImage(&texture, image);
+            }
+        });
+    }
+
+    void syncScreens() {
+        inLevelTransition = sim->phaseComplete;
+        inDefeatScreen = sim->defeated;
+        inBossIntro = sim->phase == BOSS && !sim->inBossFight && !sim->phaseComplete && !sim->defeated;
+    }
+
+    void run() {
+        AllocTracker::attach();
+        while (window.isOpen()) {
+            frameArena.reset();
+            renderer->beginFrame();
+            int ticksDue = pacer.consumeTicks();
+            // Os roteiros de tela andam mesmo fora da partida
+            for (int i = 0; i < ticksDue; ++i) {
+                ui.tick();
+            }
+            // Texturas da próxima fase que a thread já decodificou
+            textures.pump();
+            AllocScope inputScope(ALLOC_INPUT);
+            // Painéis de 240 Hz mandam vários movimentos por frame: o que passar
+            // do limite fica na fila do SFML para o próximo frame
+            Event event;
+            int polled = 0;
+            while (polled < MAX_EVENTS_PER_FRAME && window.pollEvent(event)) {
+                polled++;
+                if (event.type == Event::Closed) {
+                    window.close();
+                } else if (event.type == Event::Resized) {
+                    staticLayer.invalidate();
+                }
+                PointerEvent pointer;
+                if (toPointerEvent(event, pointer)) {
+                    inputClock.restart();
+                    queuePointer(pointer);
+                }
+            }
+
+            // Na partida a entrada entra no próximo tick; nas outras telas, já
+            if (!inGameplay()) {
+                applyPendingInput();
+            }
+
+            // Daqui até o display, o que não for update/áudio conta como render
+            AllocScope renderScope(ALLOC_RENDER);
+
+            if (inGameplay()) {
+                // Passo fixo: a 30 fps rodam dois ticks por frame
+                for (int i = 0; i < ticksDue; ++i) {
+                    update();
+                }
+            } else if (inDefeatScreen && versus) {
+                // O adversário pode ainda precisar das nossas entradas para fechar a partida
+                versusLink->receive(*versus);
+                versusLink->send(*versus);
+            }
+            renderScreen();
+            presentFrame();
+        }
+
+        saveReplay();
+
+        if (GLYPH_CACHE_DEBUG) {
+            cout << "Glifos rasterizados apos o carregamento: " << glyphCache.lateGlyphs << endl;
+        }
+        if (frameStats) {
+            pacer.printStats();
+            if (renderer->frames > 0) {
+                cout << "Desenho por frame: " << renderer->total.drawCalls / renderer->frames << " chamadas, "
+                     << renderer->total.vertices / renderer->frames << " vertices" << endl;
+            }
+            assets.printStats();
+            textures.printStats();
+        }
+        if (latencyStats) {
+            inputLatency.print();
+        }
+        if (ALLOC_TRACKING) {
+            AllocTracker::printSummary();
+        }
+    }
+};
+
+
+// --- Simulação em lote ---
+// Roda milhares de partidas sem janela com jogadores automáticos para
+// avaliar o balanceamento: main.exe --batch [opções] (veja printBatchUsage).
+
+struct BatchConfig {
+    int sessions = 1000;
+    int threads = 0; // 0 = todos os núcleos
+    unsigned seed = 12345;
+    float maxTime = 900.0f; // Segundos de jogo por partida
+    float curveStep = 10.0f; // Intervalo da curva de reputação
+    bool randomPlayer = false;
+    float reactionTime = 0.6f; // Segundos entre toques
+    float accuracy = 0.9f; // Chance de acertar a lixeira
+    float powerUpRate = 0.8f; // Chance de pegar um power-up visível
+    string csvFile;
+};
+
+// Jogador automático: toca na tela como um jogador de verdade, via Simulation::handleTap
+class SimPlayer {
+public:
+    const BatchConfig& config;
+    mt19937 rng;
+    float cooldown;
+
+    SimPlayer(const BatchConfig& c, unsigned seed) : config(c), rng(seed), cooldown(c.reactionTime) {}
+
+    float random01() {
+        return uniform_real_distribution<float>(0.0f, 1.0f)(rng);
+    }
+
+    int randomInt(int n) {
+        return uniform_int_distribution<int>(0, n - 1)(rng);
+    }
+
+    static Vector2f center(const FloatRect& rect) {
+        return Vector2f(rect.left + rect.width / 2, rect.top + rect.height / 2);
+    }
+
+    void act(Simulation& sim) {
+        cooldown -= SIM_DT;
+        if (cooldown > 0) return;
+        cooldown = config.reactionTime * (0.5f + random01());
+
+        // Power-ups primeiro, como um jogador atento faria
+        if (!sim.activePowerUps.empty() && random01() < config.powerUpRate) {
+            const PowerUp& powerUp = sim.activePowerUps[randomInt(sim.activePowerUps.size())];
+            sim.handleTap(powerUp.position);
+            return;
+        }
+
+        if (sim.selectedWasteIndex == -1) {
+            if (sim.activeWastes.empty()) return;
+            // Scripted pega o lixo mais próximo do chão; aleatório pega qualquer um
+            size_t target = 0;
+            if (config.randomPlayer) {
+                target = randomInt(sim.activeWastes.size());
+            } else {
+                for (size_t i = 1; i < sim.activeWastes.size(); ++i) {
+                    if (sim.activeWastes[i].position.y > sim.activeWastes[target].position.y) {
+                        target = i;
+                    }
+                }
+            }
+            sim.handleTap(center(sim.wasteBounds(sim.activeWastes[target])));
+            return;
+        }
+
+        WasteType type = sim.activeWastes[sim.selectedWasteIndex].type;
+        WasteType bin = type;
+        if (config.randomPlayer || random01() >= config.accuracy) {
+            bin = sim.binTypes[randomInt(sim.binTypes.size())];
+        }
+        sim.handleTap(center(sim.binBounds[bin]));
+    }
+};
+
+struct SessionResult {
+    bool won = false;
+    bool defeated = false;
+    int finalPhase = 0;
+    float phaseTime[BOSS + 1] = {};
+    bool phaseCompleted[BOSS + 1] = {};
+    vector<float> reputationCurve; // Reputação (ou vida, no boss) a cada curveStep
+};
+
+SessionResult runSession(const BalanceParams& params, const SpriteMetrics& metrics,
+                         const BatchConfig& config, unsigned seed) {
+    Simulation sim(params, seed);
+    sim.metrics = metrics;
+    sim.reset();
+    SimPlayer player(config, seed * 2654435761u + 1);
+
+    SessionResult result;
+    int maxTicks = static_cast<int>(config.maxTime * SIM_TICK_RATE);
+    int curveTicks = max(1, static_cast<int>(config.curveStep * SIM_TICK_RATE));
+
+    for (int tick = 0; tick < maxTicks; ++tick) {
+        if (tick % curveTicks == 0) {
+            result.reputationCurve.push_back(static_cast<float>(sim.inBossFight ? sim.playerLife : sim.reputation));
+        }
+
+        if (sim.defeated) {
+            result.defeated = true;
+            break;
+        }
+        if (sim.phaseComplete) {
+            result.phaseTime[sim.phase] = sim.phaseTime();
+            result.phaseCompleted[sim.phase] = true;
+            if (sim.phase == BOSS) {
+                result.won = true;
+                break;
+            }
+            // Tela de transição confirmada imediatamente
+            sim.advancePhase();
+            if (sim.phase == BOSS) {
+                sim.startBossFight();
+            }
+        }
+
+        player.act(sim);
+        sim.tick();
+        sim.events.clear();
+    }
+
+    result.finalPhase = sim.phase;
+    if (!result.won && !result.defeated) {
+        result.phaseTime[sim.phase] = sim.phaseTime();
+    }
+    return result;
+}
+
+struct BatchStats {
+    int sessions = 0;
+    int wins = 0;
+    int defeats = 0;
+    int phaseReached[BOSS + 1] = {};
+    int phaseCompleted[BOSS + 1] = {};
+    double phaseTimeSum[BOSS + 1] = {}; // Só das fases concluídas
+    vector<double> curveSum;
+    vector<int> curveCount;
+
+    void add(const SessionResult& result) {
+        sessions++;
+        if (result.won) wins++;
+        if (result.defeated) defeats++;
+        for (int p = 0; p <= result.finalPhase; p++) {
+            phaseReached[p]++;
+            if (result.phaseCompleted[p]) {
+                phaseCompleted[p]++;
+                phaseTimeSum[p] += result.phaseTime[p];
+            }
+        }
+        if (curveSum.size() < result.reputationCurve.size()) {
+            curveSum.resize(result.reputationCurve.size(), 0.0);
+            curveCount.resize(result.reputationCurve.size(), 0);
+        }
+        for (size_t i = 0; i < result.reputationCurve.size(); i++) {
+            curveSum[i] += result.reputationCurve[i];
+            curveCount[i]++;
+        }
+    }
+
+    void merge(const BatchStats& other) {
+        sessions += other.sessions;
+        wins += other.wins;
+        defeats += other.defeats;
+        for (int p = 0; p <= BOSS; p++) {
+            phaseReached[p] += other.phaseReached[p];
+            phaseCompleted[p] += other.phaseCompleted[p];
+            phaseTimeSum[p] += other.phaseTimeSum[p];
+        }
+        if (curveSum.size() < other.curveSum.size()) {
+            curveSum.resize(other.curveSum.size(), 0.0);
+            curveCount.resize(other.curveSum.size(), 0);
+        }
+        for (size_t i = 0; i < other.curveSum.size(); i++) {
+            curveSum[i] += other.curveSum[i];
+            curveCount[i] += other.curveCount[i];
+        }
+    }
+
+    double percent(int count, int total) const {
+        return total > 0 ? 100.0 * count / total : 0.0;
+    }
+
+    double averagePhaseTime(int p) const {
+        return phaseCompleted[p] > 0 ? phaseTimeSum[p] / phaseCompleted[p] : 0.0;
+    }
+
+    double bossWinRate() const {
+        return percent(wins, phaseReached[BOSS]);
+    }
+};
+
+// Distribui as partidas entre as threads; cada partida tem semente própria,
+// então o resultado não depende do número de threads
+BatchStats runParamSet(const BalanceParams& params, const SpriteMetrics& metrics, const BatchConfig& config) {
+    int threadCount = config.threads > 0 ? config.threads : max(1u, thread::hardware_concurrency());
+    atomic<int> nextSession(0);
+    vector<BatchStats> partial(threadCount);
+    vector<thread> workers;
+
+    for (int t = 0; t < threadCount; t++) {
+        workers.emplace_back([&, t]() {
+            int i;
+            while ((i = nextSession++) < config.sessions) {
+                partial[t].add(runSession(params, metrics, config, config.seed + i));
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    BatchStats total;
+    for (const auto& stats : partial) {
+        total.merge(stats);
+    }
+    return total;
+}
+
+struct ParamSweep {
+    string name;
+    vector<float> values;
+};
+
+struct ParamSet {
+    BalanceParams params;
+    string label;
+};
+
+// Produto cartesiano de todas as varreduras
+vector<ParamSet> expandSweeps(const BalanceParams& base, const vector<ParamSweep>& sweeps) {
+    vector<ParamSet> sets = {ParamSet{base, "padrao"}};
+    for (const auto& sweep : sweeps) {
+        vector<ParamSet> expanded;
+        for (const auto& set : sets) {
+            for (float value : sweep.values) {
+                ParamSet next = set;
+                setBalanceParam(next.params, sweep.name, value);
+                ostringstream label;
+                label << (set.label == "padrao" ? "" : set.label + " ") << sweep.name << "=" << value;
+                next.label = label.str();
+                expanded.push_back(next);
+            }
+        }
+        sets = expanded;
+    }
+    return sets;
+}
+
+void printBatchReport(const ParamSet& set, const BatchStats& stats, const BatchConfig& config) {
+    cout << "\n=== " << set.label << " ===" << endl;
+    cout << fixed << setprecision(1);
+    cout << "Partidas: " << stats.sessions
+         << " | Conclusao: " << stats.percent(stats.wins, stats.sessions) << "%"
+         << " | Derrotas: " << stats.percent(stats.defeats, stats.sessions) << "%"
+         << " | Vitoria no boss: " << stats.bossWinRate() << "% (de " << stats.phaseReached[BOSS] << ")" << endl;
+
+    cout << left << setw(22) << "Fase" << right << setw(12) << "Alcancada" << setw(12) << "Concluida"
+         << setw(14) << "Tempo (s)" << endl;
+    for (int p = 0; p <= BOSS; p++) {
+        cout << left << setw(22) << PHASE_CONFIGS[p].label << right
+             << setw(11) << stats.percent(stats.phaseReached[p], stats.sessions) << "%"
+             << setw(11) << stats.percent(stats.phaseCompleted[p], stats.phaseReached[p]) << "%"
+             << setw(14) << stats.averagePhaseTime(p) << endl;
+    }
+
+    cout << "Reputacao media a cada " << config.curveStep << "s:";
+    for (size_t i = 0; i < stats.curveSum.size(); i++) {
+        cout << " " << setprecision(0) << stats.curveSum[i] / stats.curveCount[i];
+    }
+    cout << setprecision(1) << endl;
+}
+
+void writeBatchCsv(const string& file, const vector<ParamSet>& sets, const vector<BatchStats>& results) {
+    ofstream out(file);
+    if (!out) {
+        cerr << "Erro ao criar " << file << endl;
+        return;
+    }
+    out << "params,sessions,completion_rate,defeat_rate,boss_win_rate";
+    for (int p = 0; p <= BOSS; p++) {
+        out << ",phase" << p << "_reached,phase" << p << "_completed,phase" << p << "_time";
+    }
+    out << ",reputation_curve\n";
+
+    for (size_t s = 0; s < sets.size(); s++) {
+        const BatchStats& stats = results[s];
+        out << "\"" << sets[s].label << "\"," << stats.sessions << ","
+            << stats.percent(stats.wins, stats.sessions) << ","
+            << stats.percent(stats.defeats, stats.sessions) << ","
+            << stats.bossWinRate();
+        for (int p = 0; p <= BOSS; p++) {
+            out << "," << stats.percent(stats.phaseReached[p], stats.sessions)
+                << "," << stats.percent(stats.phaseCompleted[p], stats.phaseReached[p])
+                << "," << stats.averagePhaseTime(p);
+        }
+        out << ",";
+        for (size_t i = 0; i < stats.curveSum.size(); i++) {
+            out << (i ? ";" : "") << stats.curveSum[i] / stats.curveCount[i];
+        }
+        out << "\n";
+    }
+}
+
+// Valor numérico de uma opção; false se sobrar texto ou não for número
+template <class T>
+bool parseNumber(const string& text, T& value) {
+    istringstream in(text);
+    T parsed;
+    if (!(in >> parsed) || !(in >> ws).eof()) {
+        return false;
+    }
+    value = parsed;
+    return true;
+}
+
+void printBatchUsage() {
+    cout << "Uso: main.exe --batch [opcoes]\n"
+            "  --sessions N         partidas por conjunto de parametros (1000)\n"
+            "  --threads N          threads de trabalho (todos os nucleos)\n"
+            "  --seed N             semente base (12345)\n"
+            "  --max-time S         segundos de jogo por partida (900)\n"
+            "  --curve-step S       intervalo da curva de reputacao (10)\n"
+            "  --player scripted|random\n"
+            "  --reaction S         segundos entre toques do jogador (0.6)\n"
+            "  --accuracy P         chance de acertar a lixeira (0.9)\n"
+            "  --powerups P         chance de pegar um power-up visivel (0.8)\n"
+            "  --set nome=valor     altera um parametro de BalanceParams\n"
+            "  --sweep nome=a:b:passo  varre um parametro (pode repetir)\n"
+            "  --csv arquivo        grava o resumo em CSV\n";
+}
+
+int runBatch(int argc, char* argv[]) {
+    BatchConfig config;
+    BalanceParams base;
+    vector<ParamSweep> sweeps;
+
+    for (int i = 2; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--help") {
+            printBatchUsage();
+            return 0;
+        }
+        if (i + 1 >= argc) {
+            cerr << "Falta valor para " << arg << endl;
+            printBatchUsage();
+            return 1;
+        }
+        string value = argv[++i];
+
+        bool valid = true;
+        if (arg == "--sessions") valid = parseNumber(value, config.sessions);
+        else if (arg == "--threads") valid = parseNumber(value, config.threads);
+        else if (arg == "--seed") valid = parseNumber(value, config.seed);
+        else if (arg == "--max-time") valid = parseNumber(value, config.maxTime);
+        else if (arg == "--curve-step") valid = parseNumber(value, config.curveStep);
+        else if (arg == "--player") config.randomPlayer = (value == "random");
+        else if (arg == "--reaction") valid = parseNumber(value, config.reactionTime);
+        else if (arg == "--accuracy") valid = parseNumber(value, config.accuracy);
+        else if (arg == "--powerups") valid = parseNumber(value, config.powerUpRate);
+        else if (arg == "--csv") config.csvFile = value;
+        else if (arg == "--set" || arg == "--sweep") {
+            size_t eq = value.find('=');
+            string name = value.substr(0, eq);
+            BalanceParams probe;
+            if (eq == string::npos || !setBalanceParam(probe, name, 0.0f)) {
+                cerr << "Parametro desconhecido: " << value << endl;
+                return 1;
+            }
+            if (arg == "--set") {
+                float amount = 0;
+                valid = parseNumber(value.substr(eq + 1), amount);
+                setBalanceParam(base, name, amount);
+            } else {
+                // a:b:passo
+                float from = 0, to = 0, step = 0;
+                char sep1 = 0, sep2 = 0;
+                istringstream range(value.substr(eq + 1));
+                if (!(range >> from >> sep1 >> to >> sep2 >> step) || step <= 0) {
+                    cerr << "Varredura invalida: " << value << endl;
+                    return 1;
+                }
+                ParamSweep sweep{name, {}};
+                for (int k = 0; from + k * step <= to + step * 0.001f; k++) {
+                    sweep.values.push_back(from + k * step);
+                }
+                sweeps.push_back(sweep);
+            }
+        }
+        else {
+            cerr << "Opcao desconhecida: " << arg << endl;
+            printBatchUsage();
+            return 1;
+        }
+        if (!valid) {
+            cerr << "Valor invalido para " << arg << ": " << value << endl;
+            printBatchUsage();
+            return 1;
+        }
+    }
+
+    SpriteMetrics metrics = SpriteMetrics::loadFromImages();
+    vector<ParamSet> sets = expandSweeps(base, sweeps);
+    vector<BatchStats> results;
+
+    for (const auto& set : sets) {
+        Clock clock;
+        BatchStats stats = runParamSet(set.params, metrics, config);
+        printBatchReport(set, stats, config);
+        cout << "(" << clock.getElapsedTime().asSeconds() << "s)" << endl;
+        results.push_back(stats);
+    }
+
+    if (!config.csvFile.empty()) {
+        writeBatchCsv(config.csvFile, sets, results);
+    }
+    return 0;
+}
+
+// --- Benchmark de renderização sem janela ---
+// Um Game sem janela desenha a partida com as suas próprias funções (camada
+// estática, resíduos, power-ups, HUD e textos) no backend nulo, que só conta
+// chamadas, ou no de software, com as texturas da fase lidas dos arquivos. O
+// SimPlayer joga com semente fixa, então o mesmo número de frames gera sempre
+// a mesma imagem no backend de software.
+//
+// renderGeometryScene é a cena só de geometria do --export-replay --geometry,
+// para máquinas sem OpenGL: lixeiras, resíduos e power-ups viram retângulos
+// do tamanho dos sprites, mais brilhos, partículas e barras.
+#define RENDER_BENCH_SEED 12345
+
+const Color BENCH_WASTE_COLORS[NONE] = {
+    Color(70, 120, 220),  // Papel
+    Color(220, 60, 60),   // Plástico
+    Color(240, 200, 40),  // Metal
+    Color(60, 170, 80),   // Vidro
+    Color(130, 90, 50),   // Orgânico
+    Color(150, 150, 150), // Eletrônico
+    Color(230, 120, 30)   // Bateria
+};
+
+void renderGeometryScene(RenderBackend& renderer, const Simulation& sim, ParticleSystem& particles,
+                      GlowMesh& glow, RectangleShape& box) {
+    renderer.clear(Color(30, 70, 40));
+
+    box.setOutlineColor(Color::White);
+    for (const auto& entry : sim.binBounds) {
+        box.setPosition(entry.second.left + 15, entry.second.top + 15);
+        box.setSize(Vector2f(entry.second.width - 30, entry.second.height - 30));
+        box.setFillColor(BENCH_WASTE_COLORS[entry.first]);
+        box.setOutlineThickness(3);
+        renderer.draw(box);
+    }
+
+    box.setOutlineThickness(0);
+    for (const auto& waste : sim.activeWastes) {
+        box.setPosition(waste.position);
+        box.setSize(sim.metrics.wasteSize[waste.type] * WASTE_SCALE);
+        box.setFillColor(waste.selected ? Color(255, 255, 0) : BENCH_WASTE_COLORS[waste.type]);
+        renderer.draw(box);
+    }
+
+    glow.setTick(sim.timers.now());
+    for (const auto& powerUp : sim.activePowerUps) {
+        glow.draw(renderer, powerUp.position);
+        box.setPosition(powerUp.position - Vector2f(20, 20));
+        box.setSize(Vector2f(40, 40));
+        box.setFillColor(Color(255, 215, 0));
+        renderer.draw(box);
+    }
+
+    particles.render(renderer);
+
+    box.setPosition(MOBILE_RESOLUTION_X * 0.65f, 80);
+    box.setSize(Vector2f(MOBILE_RESOLUTION_X * 0.3f, 25));
+    box.setFillColor(Color(50, 50, 50));
+    renderer.draw(box);
+    float ratio = sim.inBossFight ? sim.playerLife / 100.0f : sim.reputation / 100.0f;
+    box.setSize(Vector2f(MOBILE_RESOLUTION_X * 0.3f * max(0.0f, ratio), 25));
+    box.setFillColor(Color(0, 200, 0));
+    renderer.draw(box);
+}
+
+// main.exe --render-bench null|cpu [frames] [imagem.png]
+int runRenderBench(int argc, char* argv[]) {
+    string name = argc > 2 ? argv[2] : "cpu";
+    int frames = argc > 3 ? atoi(argv[3]) : 3600;
+    string imageFile = argc > 4 ? argv[4] : "";
+
+    unique_ptr<RenderBackend> renderer;
+    SoftwareBackend* software = nullptr;
+    if (name == "null") {
+        renderer.reset(new NullBackend());
+    } else if (name == "cpu") {
+        software = new SoftwareBackend();
+        renderer.reset(software);
+    } else {
+        cerr << "Renderizador sem janela desconhecido: " << name << " (use null ou cpu)" << endl;
+        return 1;
+    }
+
+    // O jogo desenha pelas suas próprias funções; a partida é do SimPlayer
+    RenderBackend* backend = renderer.get();
+    Game game(false, false, false, "null", "", "pt", TEXTURE_BUDGET_MB, false);
+    game.setRenderer(move(renderer));
+    BatchConfig config;
+    SimPlayer player(config, RENDER_BENCH_SEED);
+    game.startOffscreen([](Simulation& sim) {
+        sim.rng.seed(RENDER_BENCH_SEED);
+        sim.reset();
+    });
+    bool newPhase = true;
+    auto step = [&](Simulation& sim) {
+        if (sim.phaseComplete) {
+            if (sim.phase == BOSS) return false;
+            sim.advancePhase();
+            if (sim.phase == BOSS) {
+                sim.startBossFight();
+            }
+            newPhase = true;
+        }
+        player.act(sim);
+        sim.tick();
+        return !sim.defeated;
+    };
+
+    Clock clock;
+    Time renderTime;
+    for (int frame = 0; frame < frames && game.tickOffscreen(step); ++frame) {
+        // Texturas da fase nova sobem no tick; registra antes de desenhar
+        if (software && newPhase) {
+            game.registerTextureImages(*software);
+            newPhase = false;
+        }
+        Time start = clock.getElapsedTime();
+        game.renderOffscreen();
+        renderTime += clock.getElapsedTime() - start;
+    }
+
+    long drawn = max(1L, backend->frames);
+    cout << "Renderizador: " << name << " | Frames: " << backend->frames
+         << " | " << renderTime.asSeconds() * 1000.0f / drawn << " ms/frame"
+         << " | " << backend->total.drawCalls / drawn << " chamadas e "
+         << backend->total.vertices / drawn << " vertices por frame" << endl;
+    if (software) {
+        cout << "Checksum da imagem final: " << hex << software->checksum() << dec << endl;
+        if (!imageFile.empty() && !software->snapshot().saveToFile(imageFile)) {
+            cerr << "Erro ao salvar imagem: " << imageFile << endl;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// --- Exportação de replays ---
+// Reproduz um replay gravado com --record sem janela, em taxa fixa de
+// quadros, desenhando a tela do Game (fundo, sprites, textos, HUD) pelo
+// SfmlBackend em duas RenderTexture alternadas: enquanto um quadro é
+// desenhado num buffer, o anterior é lido do outro, que a GPU já terminou.
+// Cada quadro lido é copiado para um slot livre (dois por thread, então a
+// cópia do próximo não espera a compressão do anterior) e um pool de
+// threads grava os PNGs. O vídeo bruto sai em ordem, na thread de desenho.
+// Sem OpenGL, --geometry exporta a cena de formas do --render-bench pelo
+// backend de software.
+#define EXPORT_SLOTS_PER_THREAD 2
+
+class FrameExporter {
+public:
+    FrameExporter(const string& filePrefix, int threads, unsigned w, unsigned h)
+        : prefix(filePrefix), width(w), height(h) {
+        slots.resize(threads * EXPORT_SLOTS_PER_THREAD);
+        for (size_t i = 0; i < slots.size(); ++i) {
+            slots[i].pixels.resize(width * height * 4);
+            freeSlots.push_back(static_cast<int>(i));
+        }
+        for (int i = 0; i < threads; ++i) {
+            workers.emplace_back([this] { work(); });
+        }
+    }
+
+    ~FrameExporter() {
+        finish();
+    }
+
+    // Copia o quadro para um slot livre; só bloqueia se todos estiverem na fila
+    void submit(const Uint8* pixels, int index) {
+        unique_lock<mutex> guard(lock);
+        changed.wait(guard, [this] { return !freeSlots.empty(); });
+        int slot = freeSlots.back();
+        freeSlots.pop_back();
+        guard.unlock();
+
+        copy(pixels, pixels + slots[slot].pixels.size(), slots[slot].pixels.begin());
+        slots[slot].index = index;
+
+        guard.lock();
+        ready.push(slot);
+        changed.notify_all();
+    }
+
+    // Espera os PNGs pendentes; devolve quantos falharam
+    int finish() {
+        {
+            lock_guard<mutex> guard(lock);
+            closing = true;
+        }
+        changed.notify_all();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        workers.clear();
+        return failures;
+    }
+
+private:
+    struct Slot {
+        vector<Uint8> pixels;
+        int index = 0;
+    };
+
+    string prefix;
+    unsigned width, height;
+    vector<Slot> slots;
+    vector<int> freeSlots;
+    queue<int> ready;
+    mutex lock;
+    condition_variable changed;
+    vector<thread> workers;
+    bool closing = false;
+    atomic<int> failures{0};
+
+    void work() {
+        Image image;
+        char name[16];
+        while (true) {
+            unique_lock<mutex> guard(lock);
+            changed.wait(guard, [this] { return !ready.empty() || closing; });
+            if (ready.empty()) {
+                return;
+            }
+            int slot = ready.front();
+            ready.pop();
+            guard.unlock();
+
+            image.create(width, height, slots[slot].pixels.data());
+            snprintf(name, sizeof(name), "%05d.png", slots[slot].index);
+            if (!image.saveToFile(prefix + name)) {
+                failures++;
+            }
+
+            guard.lock();
+            freeSlots.push_back(slot);
+            changed.notify_all();
+        }
+    }
+};
+
+void printExportUsage() {
+    cout << "Uso: main.exe --export-replay partida.rep [opcoes]\n"
+            "  --png prefixo        grava prefixo00000.png, prefixo00001.png, ...\n"
+            "  --raw arquivo        grava os quadros RGBA em sequencia (video bruto)\n"
+            "  --fps N              quadros por segundo de jogo (30)\n"
+            "  --threads N          threads de compressao PNG (todos os nucleos)\n"
+            "  --geometry           cena so de formas, sem OpenGL (backend de software)\n";
+}
+
+int runExportReplay(int argc, char* argv[]) {
+    if (argc < 3) {
+        printExportUsage();
+        return 1;
+    }
+    string replayFile = argv[2];
+    string pngPrefix, rawFile;
+    int fps = 30;
+    int threads = max(1u, thread::hardware_concurrency());
+    bool geometry = false;
+    for (int i = 3; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--geometry") {
+            geometry = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            cerr << "Falta valor para " << arg << endl;
+            printExportUsage();
+            return 1;
+        }
+        string value = argv[++i];
+        bool valid = true;
+        if (arg == "--png") pngPrefix = value;
+        else if (arg == "--raw") rawFile = value;
+        else if (arg == "--fps") valid = parseNumber(value, fps);
+        else if (arg == "--threads") valid = parseNumber(value, threads);
+        else {
+            cerr << "Opcao desconhecida: " << arg << endl;
+            printExportUsage();
+            return 1;
+        }
+        if (!valid) {
+            cerr << "Valor invalido para " << arg << ": " << value << endl;
+            printExportUsage();
+            return 1;
+        }
+    }
+    fps = max(1, fps);
+    threads = max(1, threads);
+    if (pngPrefix.empty() && rawFile.empty()) {
+        cerr << "Escolha --png e/ou --raw" << endl;
+        return 1;
+    }
+
+    Replay replay;
+    if (!replay.load(replayFile)) {
+        return 1;
+    }
+    ofstream raw;
+    if (!rawFile.empty()) {
+        raw.open(rawFile, ios::binary);
+        if (!raw) {
+            cerr << "Erro ao criar video: " << rawFile << endl;
+            return 1;
+        }
+    }
+
+    const unsigned width = MOBILE_RESOLUTION_X, height = MOBILE_RESOLUTION_Y;
+    unique_ptr<FrameExporter> exporter;
+    if (!pngPrefix.empty()) {
+        exporter.reset(new FrameExporter(pngPrefix, threads, width, height));
+    }
+    auto write = [&](const Uint8* pixels, int index) {
+        if (exporter) {
+            exporter->submit(pixels, index);
+        }
+        if (raw.is_open()) {
+            raw.write(reinterpret_cast<const char*>(pixels), width * height * 4);
+        }
+    };
+
+    Clock clock;
+    ReplayPlayer player(replay);
+    float ticksPerFrame = static_cast<float>(SIM_TICK_RATE) / fps;
+    float tickDebt = 0;
+    bool playing = true;
+    int frames = 0;
+    if (geometry) {
+        Simulation sim;
+        sim.metrics = SpriteMetrics::loadFromImages();
+        player.start(sim);
+        SoftwareBackend renderer(width, height);
+        ParticleSystem particles;
+        GlowMesh glow;
+        RectangleShape box;
+        while (playing) {
+            // Taxa fixa: a 30 fps, dois ticks de simulação por quadro
+            for (tickDebt += ticksPerFrame; tickDebt >= 1.0f && playing; tickDebt -= 1.0f) {
+                playing = player.step(sim);
+                particles.emit(sim.events);
+                sim.events.clear();
+                particles.update();
+            }
+            renderer.beginFrame();
+            renderGeometryScene(renderer, sim, particles, glow, box);
+            write(renderer.pixels.data(), frames++);
+        }
+    } else {
+        RenderTexture buffers[2];
+        for (auto& buffer : buffers) {
+            if (!buffer.create(width, height)) {
+                cerr << "Erro ao criar textura de renderizacao (sem OpenGL, use --geometry)" << endl;
+                return 1;
+            }
+        }
+        DynamicResolution resolution;
+        Game game(false, false, false, "null", "", "pt", TEXTURE_BUDGET_MB, false);
+        SfmlBackend* backend = new SfmlBackend(buffers[0], resolution);
+        game.setRenderer(unique_ptr<RenderBackend>(backend));
+        game.startOffscreen([&](Simulation& sim) { player.start(sim); });
+        auto step = [&](Simulation& sim) { return player.step(sim); };
+        while (playing) {
+            for (tickDebt += ticksPerFrame; tickDebt >= 1.0f && playing; tickDebt -= 1.0f) {
+                playing = game.tickOffscreen(step);
+            }
+            backend->target = &buffers[frames % 2];
+            game.renderOffscreen();
+            backend->target->display();
+            // O quadro anterior, no outro buffer, já saiu da GPU
+            if (frames > 0) {
+                Image image = buffers[(frames - 1) % 2].getTexture().copyToImage();
+                write(image.getPixelsPtr(), frames - 1);
+            }
+            frames++;
+        }
+        if (frames > 0) {
+            Image image = buffers[(frames - 1) % 2].getTexture().copyToImage();
+            write(image.getPixelsPtr(), frames - 1);
+        }
+    }
+
+    int failures = exporter ? exporter->finish() : 0;
+    float elapsed = clock.getElapsedTime().asSeconds();
+    float gameSeconds = static_cast<float>(frames) / fps;
+    cout << "Quadros: " << frames << " (" << gameSeconds << "s de jogo) em " << elapsed << "s | "
+         << gameSeconds / max(elapsed, 0.001f) << "x o tempo real" << endl;
+    if (raw.is_open()) {
+        cout << "Para converter: ffmpeg -f rawvideo -pixel_format rgba -video_size "
+             << width << "x" << height << " -framerate " << fps
+             << " -i " << rawFile << " saida.mp4" << endl;
+    }
+    if (failures > 0) {
+        cerr << "Erro ao salvar " << failures << " quadros PNG" << endl;
+        return 1;
+    }
+    return 0;
+}
+
+// --- Servidor de sessões ---
+// Muitas partidas independentes num processo, divididas entre threads
+// (shards) que rodam a 60 Hz. Os clientes mandam toques e recebem só o que
+// mudou no estado, em pacotes sf::Packet por TCP local. A rede fica toda na
+// thread principal; os shards trocam comandos e pacotes com ela por filas.
+#define SERVER_PORT 53000
+#define SERVER_KEYFRAME_TICKS 60 // Posições completas dos resíduos a cada segundo
+#define SERVER_REPORT_SECONDS 5
+#define SERVER_CLIENT_QUEUE 1024 // Pacotes parados na fila antes de derrubar o cliente
+#define SERVER_TICK_SAMPLES 4096 // Últimos ticks de cada shard guardados para os percentis (~68 s)
+#define SERVER_SESSIONS_PER_CLIENT 256 // Sessões abertas por conexão; o NET_JOIN além disso é recusado
+
+// Primeiro byte de cada pacote
+enum NetMessage {
+    NET_JOIN = 1,    // c->s: etiqueta do cliente, semente
+    NET_JOINED,      // s->c: etiqueta, id da sessão (0: recusada, a conexão está no limite)
+    NET_INPUT,       // c->s: sessão, sequência, ReplayInput::Type, x, y
+    NET_LEAVE,       // c->s: sessão
+    NET_STATE,       // s->c: delta de estado (ver StateField)
+    NET_STATS,       // c->s: pede as estatísticas; 1 = zera depois
+    NET_STATS_REPLY
+};
+
+// Blocos presentes num NET_STATE, nesta ordem
+enum StateField {
+    STATE_SCORE = 1 << 0,      // Int32
+    STATE_REPUTATION = 1 << 1, // Int16
+    STATE_COMBO = 1 << 2,      // Uint16
+    STATE_PHASE = 1 << 3,      // Uint8
+    STATE_LIVES = 1 << 4,      // Int16 jogador, Int16 boss
+    STATE_FLAGS = 1 << 5,      // Uint8 (StateFlag)
+    STATE_OBJECTS = 1 << 6,    // Resíduos e power-ups que entraram ou saíram
+    STATE_KEYFRAME = 1 << 7    // Posição de todos os resíduos
+};
+
+enum StateFlag {
+    FLAG_DEFEATED = 1 << 0,
+    FLAG_PHASE_COMPLETE = 1 << 1,
+    FLAG_BOSS_FIGHT = 1 << 2,
+    FLAG_SPECIAL_EVENT = 1 << 3
+};
+
+struct ServerSession {
+    Uint32 id;
+    int client;
+    Simulation sim;
+    Uint32 ackSeq = 0;   // Última entrada aplicada
+    Uint32 sentAck = 0;
+    bool fresh = true;   // Ainda não mandou o estado inicial
+
+    // Último estado enviado
+    int score = 0, reputation = 0, combo = 0, phase = -1, playerLife = 0, bossLife = 0;
+    Uint8 flags = 0;
+    vector<unsigned> wasteIds, powerUpIds; // Ordenados (ids só crescem)
+
+    // Áreas de toque com o tamanho real das texturas, como no Game: o
+    // servidor decide os acertos e precisa concordar com o que o jogador viu
+    ServerSession(Uint32 sessionId, int clientId, unsigned seed, const SpriteMetrics& metrics)
+        : id(sessionId), client(clientId), sim(BalanceParams(), seed) {
+        sim.metrics = metrics;
+        sim.reset(); // Refaz binBounds com os tamanhos novos
+    }
+};
+
+// Conexão de um cliente. O socket não bloqueia: o que o sistema não aceitar
+// agora fica na fila e é tentado de novo no próximo laço, para que um
+// cliente lento não segure as sessões dos outros.
+struct ServerClient {
+    unique_ptr<TcpSocket> socket;
+    deque<Packet> outbox;
+    int sessions = 0; // Abertas por esta conexão
+
+    void send(Packet packet) {
+        outbox.push_back(move(packet));
+    }
+
+    // false se a conexão caiu ou o cliente parou de ler
+    bool flush() {
+        while (!outbox.empty()) {
+            // O sf::Packet guarda quanto já foi enviado, então um envio
+            // parcial tem que ser repetido com o mesmo pacote
+            Socket::Status status = socket->send(outbox.front());
+            if (status == Socket::Partial || status == Socket::NotReady) break;
+            if (status != Socket::Done) return false;
+            outbox.pop_front();
+        }
+        return outbox.size() <= SERVER_CLIENT_QUEUE;
+    }
+};
+
+struct ShardCommand {
+    NetMessage type; // NET_JOIN, NET_INPUT ou NET_LEAVE
+    Uint32 session;
+    int client;
+    unsigned seed;
+    Uint32 seq;
+    ReplayInput input;
+    const SpriteMetrics* metrics; // Só no NET_JOIN; lidas uma vez em runServer
+};
+
+struct OutgoingPacket {
+    int client;
+    Packet packet;
+};
+
+// Percentil p (0..1) de amostras já ordenadas
+Int64 percentile(const vector<Int64>& sorted, float p) {
+    if (sorted.empty()) return 0;
+    return sorted[min(sorted.size() - 1, static_cast<size_t>(p * sorted.size()))];
+}
+
+class ServerShard {
+public:
+    atomic<int> sessionCount{0};
+
+    ~ServerShard() {
+        stop();
+    }
+
+    void start() {
+        running = true;
+        worker = thread([this] { run(); });
+    }
+
+    void stop() {
+        running = false;
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+
+    void post(const ShardCommand& command) {
+        lock_guard<mutex> guard(lock);
+        inbox.push_back(command);
+    }
+
+    void drainOutbox(vector<OutgoingPacket>& out) {
+        lock_guard<mutex> guard(lock);
+        for (auto& outgoing : outbox) {
+            out.push_back(move(outgoing));
+        }
+        outbox.clear();
+    }
+
+    // Duração de cada tick do shard (todas as suas sessões), tempo ocupado e ticks de sessão
+    void collectStats(vector<Int64>& tickMicros, Int64& busyMicros, Uint64& sessionTicks, bool reset) {
+        lock_guard<mutex> guard(statsLock);
+        tickMicros.insert(tickMicros.end(), tickSamples, tickSamples + min<Uint64>(sampleCount, SERVER_TICK_SAMPLES));
+        busyMicros += busy;
+        sessionTicks += ticks;
+        if (reset) {
+            sampleCount = 0;
+            busy = 0;
+            ticks = 0;
+        }
+    }
+
+private:
+    thread worker;
+    atomic<bool> running{false};
+    mutex lock; // inbox e outbox
+    vector<ShardCommand> inbox;
+    vector<OutgoingPacket> outbox;
+    map<Uint32, unique_ptr<ServerSession>> sessions; // Só a thread do shard mexe
+
+    mutex statsLock;
+    Int64 tickSamples[SERVER_TICK_SAMPLES]; // Anel: o servidor pode ficar dias sem zerar
+    Uint64 sampleCount = 0;
+    Int64 busy = 0;
+    Uint64 ticks = 0;
+
+    // Rascunho do writeDelta, reaproveitado entre sessões e ticks
+    Packet delta;
+    vector<unsigned> wasteIds, powerUpIds, scratch;
+
+    void run() {
+        vector<ShardCommand> commands;
+        vector<OutgoingPacket> produced;
+        Clock clock;
+        Int64 nextTick = 0;
+        const Int64 period = 1000000 / SIM_TICK_RATE;
+
+        while (running) {
+            Int64 now = clock.getElapsedTime().asMicroseconds();
+            if (now < nextTick) {
+                sleep(microseconds(nextTick - now));
                 continue;
             }
+            // Atrasado: roda o próximo tick já, sem pular nenhum
+            nextTick = max(nextTick + period, now - period * MAX_TICKS_PER_FRAME);
+
+            {
+                lock_guard<mutex> guard(lock);
+                commands.swap(inbox);
+            }
+            Int64 start = clock.getElapsedTime().asMicroseconds();
+            for (const auto& command : commands) {
+                execute(command);
+            }
+            commands.clear();
 
-            update();
-            checkPhaseTransition();
+            for (auto& entry : sessions) {
+                ServerSession& session = *entry.second;
+                if (session.sim.running()) {
+                    session.sim.tick();
+                }
+                session.sim.events.clear();
+                // A cópia sai do tamanho exato; o rascunho fica com a capacidade
+                if (writeDelta(session)) {
+                    produced.push_back(OutgoingPacket{session.client, delta});
+                }
+            }
+            Int64 elapsed = clock.getElapsedTime().asMicroseconds() - start;
 
-            updateBackground();
-            window.draw(bgSprite);
+            {
+                lock_guard<mutex> guard(lock);
+                for (auto& outgoing : produced) {
+                    outbox.push_back(move(outgoing));
+                }
+            }
+            produced.clear();
+            {
+                lock_guard<mutex> guard(statsLock);
+                tickSamples[sampleCount++ % SERVER_TICK_SAMPLES] = elapsed;
+                busy += elapsed;
+                ticks += sessions.size();
+            }
+        }
+    }
 
-            for (const auto& bin : bins) {
-                window.draw(bin);
+    void execute(const ShardCommand& command) {
+        if (command.type == NET_JOIN) {
+            sessions[command.session].reset(new ServerSession(command.session, command.client, command.seed, *command.metrics));
+            sessionCount = static_cast<int>(sessions.size());
+            return;
+        }
+        auto found = sessions.find(command.session);
+        if (found == sessions.end()) {
+            return;
+        }
+        if (command.type == NET_LEAVE) {
+            sessions.erase(found);
+            sessionCount = static_cast<int>(sessions.size());
+        } else if (command.type == NET_INPUT) {
+            Simulation& sim = found->second->sim;
+            // O servidor é a autoridade: trocas de tela só valem quando o Game as permitiria
+            bool allowed = true;
+            if (command.input.type == ReplayInput::ADVANCE_PHASE) {
+                allowed = sim.phaseComplete && sim.phase < BOSS;
+            } else if (command.input.type == ReplayInput::START_BOSS) {
+                allowed = sim.phase == BOSS && !sim.inBossFight && !sim.phaseComplete;
             }
-            for (const auto& label : binLabels) {
-                window.draw(label);
+            if (allowed) {
+                applyInput(sim, command.input);
             }
-            for (const auto& waste : activeWastes) {
-                window.draw(waste.sprite);
+            found->second->ackSeq = command.seq;
+        }
+    }
+
+    // Ids que estão em "now" e não em "before" (os dois ordenados)
+    static void difference(const vector<unsigned>& now, const vector<unsigned>& before, vector<unsigned>& out) {
+        out.clear();
+        set_difference(now.begin(), now.end(), before.begin(), before.end(), back_inserter(out));
+    }
+
+    // Monta em delta o NET_STATE com o que mudou desde o último; false se nada mudou
+    bool writeDelta(ServerSession& session) {
+        const Simulation& sim = session.sim;
+        Uint8 flags = (sim.defeated ? FLAG_DEFEATED : 0) | (sim.phaseComplete ? FLAG_PHASE_COMPLETE : 0) |
+                      (sim.inBossFight ? FLAG_BOSS_FIGHT : 0) | (sim.specialEvent ? FLAG_SPECIAL_EVENT : 0);
+
+        wasteIds.clear();
+        powerUpIds.clear();
+        for (const auto& waste : sim.activeWastes) wasteIds.push_back(waste.id);
+        for (const auto& powerUp : sim.activePowerUps) powerUpIds.push_back(powerUp.id);
+        sort(wasteIds.begin(), wasteIds.end());
+        sort(powerUpIds.begin(), powerUpIds.end());
+
+        Uint8 mask = 0;
+        if (session.fresh || sim.score != session.score) mask |= STATE_SCORE;
+        if (session.fresh || sim.reputation != session.reputation) mask |= STATE_REPUTATION;
+        if (session.fresh || sim.combo != session.combo) mask |= STATE_COMBO;
+        if (session.fresh || sim.phase != session.phase) mask |= STATE_PHASE;
+        if (session.fresh || sim.playerLife != session.playerLife || sim.bossLife != session.bossLife) mask |= STATE_LIVES;
+        if (session.fresh || flags != session.flags) mask |= STATE_FLAGS;
+        if (wasteIds != session.wasteIds || powerUpIds != session.powerUpIds) mask |= STATE_OBJECTS;
+        if (sim.running() && sim.timers.now() % SERVER_KEYFRAME_TICKS == 0 && !sim.activeWastes.empty()) mask |= STATE_KEYFRAME;
+        if (mask == 0 && session.ackSeq == session.sentAck) {
+            return false;
+        }
+
+        delta.clear();
+        delta << static_cast<Uint8>(NET_STATE) << session.id << static_cast<Uint32>(sim.timers.now())
+               << session.ackSeq << mask;
+        if (mask & STATE_SCORE) delta << static_cast<Int32>(sim.score);
+        if (mask & STATE_REPUTATION) delta << static_cast<Int16>(sim.reputation);
+        if (mask & STATE_COMBO) delta << static_cast<Uint16>(sim.combo);
+        if (mask & STATE_PHASE) delta << static_cast<Uint8>(sim.phase);
+        if (mask & STATE_LIVES) delta << static_cast<Int16>(sim.playerLife) << static_cast<Int16>(sim.bossLife);
+        if (mask & STATE_FLAGS) delta << flags;
+        if (mask & STATE_OBJECTS) {
+            // Resíduos novos (com velocidade, para o cliente prever a queda), resíduos que saíram,
+            // e o mesmo para power-ups
+            difference(wasteIds, session.wasteIds, scratch);
+            delta << static_cast<Uint16>(scratch.size());
+            for (const auto& waste : sim.activeWastes) {
+                if (binary_search(scratch.begin(), scratch.end(), waste.id)) {
+                    delta << static_cast<Uint32>(waste.id) << static_cast<Uint8>(waste.type)
+                           << waste.position.x << waste.position.y << waste.velocity.y;
+                }
             }
-            renderPowerUps();
-            
-            // Reposicionar textos na fase do boss
-            if (inBossFight) {
-                // Salvar posições originais
-                Vector2f originalScorePos = scoreText.getPosition();
-                Vector2f originalComboPos = comboText.getPosition();
-                Vector2f originalPhasePos = phaseText.getPosition();
-
-                // Calcular novas posições no canto superior direito
-                FloatRect scoreBounds = scoreText.getLocalBounds();
-                FloatRect comboBounds = comboText.getLocalBounds();
-                FloatRect phaseBounds = phaseText.getLocalBounds();
-
-                // Ajustar as posições para o canto direito
-                float rightMargin = 20.0f; // 20 pixels da borda direita
-                scoreText.setPosition(MOBILE_RESOLUTION_X - scoreBounds.width - rightMargin, 40);
-                comboText.setPosition(MOBILE_RESOLUTION_X - comboBounds.width - rightMargin, 90);
-                phaseText.setPosition(MOBILE_RESOLUTION_X - phaseBounds.width - rightMargin, 140);
-
-                window.draw(scoreText);
-                window.draw(comboText);
-                window.draw(phaseText); // Desenhar a fase também
-
-                // Restaurar posições originais
-                scoreText.setPosition(originalScorePos);
-                comboText.setPosition(originalComboPos);
-                phaseText.setPosition(originalPhasePos);
+            difference(session.wasteIds, wasteIds, scratch);
+            delta << static_cast<Uint16>(scratch.size());
+            for (unsigned id : scratch) delta << static_cast<Uint32>(id);
+
+            difference(powerUpIds, session.powerUpIds, scratch);
+            delta << static_cast<Uint16>(scratch.size());
+            for (const auto& powerUp : sim.activePowerUps) {
+                if (binary_search(scratch.begin(), scratch.end(), powerUp.id)) {
+                    delta << static_cast<Uint32>(powerUp.id) << static_cast<Uint8>(powerUp.type)
+                           << powerUp.position.x << powerUp.position.y;
+                }
+            }
+            difference(session.powerUpIds, powerUpIds, scratch);
+            delta << static_cast<Uint16>(scratch.size());
+            for (unsigned id : scratch) delta << static_cast<Uint32>(id);
+        }
+        if (mask & STATE_KEYFRAME) {
+            delta << static_cast<Uint16>(sim.activeWastes.size());
+            for (const auto& waste : sim.activeWastes) {
+                delta << static_cast<Uint32>(waste.id) << waste.position.x << waste.position.y;
+            }
+        }
+
+        session.fresh = false;
+        session.score = sim.score;
+        session.reputation = sim.reputation;
+        session.combo = sim.combo;
+        session.phase = sim.phase;
+        session.playerLife = sim.playerLife;
+        session.bossLife = sim.bossLife;
+        session.flags = flags;
+        session.wasteIds.swap(wasteIds);
+        session.powerUpIds.swap(powerUpIds);
+        session.sentAck = session.ackSeq;
+        return true;
+    }
+};
+
+// Ctrl+C (ou SIGTERM) encerra o servidor no fim da volta atual do loop
+volatile sig_atomic_t serverStopRequested = 0;
+
+void requestServerStop(int) {
+    serverStopRequested = 1;
+}
+
+void printServerUsage() {
+    cout << "Uso: main.exe --server [opcoes]\n"
+            "  --port N             porta TCP local (53000)\n"
+            "  --threads N          shards de simulacao (todos os nucleos)\n";
+}
+
+int runServer(int argc, char* argv[]) {
+    unsigned short port = SERVER_PORT;
+    int threads = max(1u, thread::hardware_concurrency());
+    for (int i = 2; i < argc; i++) {
+        string arg = argv[i];
+        if (i + 1 >= argc) {
+            cerr << "Falta valor para " << arg << endl;
+            printServerUsage();
+            return 1;
+        }
+        string value = argv[++i];
+        bool valid = true;
+        if (arg == "--port") valid = parseNumber(value, port);
+        else if (arg == "--threads") valid = parseNumber(value, threads);
+        else {
+            cerr << "Opcao desconhecida: " << arg << endl;
+            printServerUsage();
+            return 1;
+        }
+        if (!valid) {
+            cerr << "Valor invalido para " << arg << ": " << value << endl;
+            printServerUsage();
+            return 1;
+        }
+    }
+    threads = max(1, threads);
+
+    TcpListener listener;
+    if (listener.listen(port, IpAddress::LocalHost) != Socket::Done) {
+        cerr << "Erro ao abrir a porta " << port << endl;
+        return 1;
+    }
+    cout << "Servidor em 127.0.0.1:" << port << " com " << threads << " shards" << endl;
+    const SpriteMetrics metrics = SpriteMetrics::loadFromImages();
+
+    vector<unique_ptr<ServerShard>> shards;
+    for (int i = 0; i < threads; ++i) {
+        shards.emplace_back(new ServerShard());
+        shards.back()->start();
+    }
+    signal(SIGINT, requestServerStop);
+    signal(SIGTERM, requestServerStop);
+
+    SocketSelector selector;
+    selector.add(listener);
+    map<int, ServerClient> clients;
+    map<Uint32, int> sessionClient;      // Sessão -> cliente dono
+    int nextClient = 0;
+    Uint32 nextSession = 1;
+    vector<OutgoingPacket> outgoing;
+    Clock statsClock, reportClock;
+
+    auto shardOf = [&](Uint32 session) -> ServerShard& {
+        return *shards[session % shards.size()];
+    };
+    auto dropClient = [&](int client) {
+        selector.remove(*clients[client].socket);
+        clients.erase(client);
+        for (auto it = sessionClient.begin(); it != sessionClient.end();) {
+            if (it->second == client) {
+                shardOf(it->first).post(ShardCommand{NET_LEAVE, it->first, client, 0, 0, ReplayInput(), nullptr});
+                it = sessionClient.erase(it);
             } else {
-                window.draw(scoreText);
-                window.draw(phaseText);
-                window.draw(comboText);
+                ++it;
             }
-            
-            // Não mostrar reputação na fase do boss
-            if (!inBossFight) {
-                window.draw(reputationText);
-                window.draw(reputationBarBack);
-                window.draw(reputationBar);
+        }
+    };
+    auto collect = [&](bool reset, vector<Int64>& tickMicros, Int64& busyMicros, Uint64& sessionTicks, Int64& elapsed) {
+        for (auto& shard : shards) {
+            shard->collectStats(tickMicros, busyMicros, sessionTicks, reset);
+        }
+        elapsed = statsClock.getElapsedTime().asMicroseconds();
+        if (reset) {
+            statsClock.restart();
+        }
+        sort(tickMicros.begin(), tickMicros.end());
+    };
+    // Um pacote já completo vindo do cliente
+    auto handle = [&](int client, ServerClient& connection, Packet& packet) {
+        Uint8 type = 0;
+        packet >> type;
+        if (type == NET_JOIN) {
+            Uint32 tag = 0, seed = 0;
+            packet >> tag >> seed;
+            Uint32 session = 0;
+            if (connection.sessions < SERVER_SESSIONS_PER_CLIENT) {
+                session = nextSession++;
+                connection.sessions++;
+                sessionClient[session] = client;
+                shardOf(session).post(ShardCommand{NET_JOIN, session, client, seed, 0, ReplayInput(), &metrics});
             }
-            
-            if (comboBoostMultiplier > 1.0f) {
-                window.draw(comboMultiplierText);
+            Packet reply;
+            reply << static_cast<Uint8>(NET_JOINED) << tag << session;
+            connection.send(reply);
+        } else if (type == NET_INPUT) {
+            Uint32 session = 0, seq = 0;
+            Uint8 inputType = 0;
+            ReplayInput input{0, ReplayInput::DOWN, Vector2f()};
+            packet >> session >> seq >> inputType >> input.position.x >> input.position.y;
+            input.type = static_cast<ReplayInput::Type>(min<Uint8>(inputType, ReplayInput::START_BOSS));
+            // Só o dono da sessão pode jogar nela
+            auto owner = sessionClient.find(session);
+            if (packet && owner != sessionClient.end() && owner->second == client) {
+                shardOf(session).post(ShardCommand{NET_INPUT, session, client, 0, seq, input, nullptr});
+            }
+        } else if (type == NET_LEAVE) {
+            Uint32 session = 0;
+            packet >> session;
+            auto owner = sessionClient.find(session);
+            if (owner != sessionClient.end() && owner->second == client) {
+                shardOf(session).post(ShardCommand{NET_LEAVE, session, client, 0, 0, ReplayInput(), nullptr});
+                sessionClient.erase(owner);
+                connection.sessions--;
+            }
+        } else if (type == NET_STATS) {
+            Uint8 reset = 0;
+            packet >> reset;
+            vector<Int64> tickMicros;
+            Int64 busyMicros = 0, elapsed = 0;
+            Uint64 sessionTicks = 0;
+            collect(reset != 0, tickMicros, busyMicros, sessionTicks, elapsed);
+            Packet reply;
+            reply << static_cast<Uint8>(NET_STATS_REPLY) << static_cast<Uint32>(sessionClient.size())
+                  << static_cast<Uint32>(shards.size()) << elapsed << busyMicros << sessionTicks
+                  << percentile(tickMicros, 0.5f) << percentile(tickMicros, 0.95f)
+                  << percentile(tickMicros, 0.99f) << (tickMicros.empty() ? Int64(0) : tickMicros.back());
+            connection.send(reply);
+        }
+    };
+
+    while (!serverStopRequested) {
+        if (selector.wait(milliseconds(1))) {
+            if (selector.isReady(listener)) {
+                unique_ptr<TcpSocket> socket(new TcpSocket());
+                if (listener.accept(*socket) == Socket::Done) {
+                    socket->setBlocking(false);
+                    selector.add(*socket);
+                    clients[nextClient++].socket = move(socket);
+                }
             }
+            vector<int> closed;
+            for (auto& entry : clients) {
+                if (!selector.isReady(*entry.second.socket)) continue;
+                Packet packet;
+                Socket::Status status;
+                while ((status = entry.second.socket->receive(packet)) == Socket::Done) {
+                    handle(entry.first, entry.second, packet);
+                }
+                if (status == Socket::Disconnected || status == Socket::Error) {
+                    closed.push_back(entry.first);
+                }
+            }
+            for (int client : closed) {
+                dropClient(client);
+            }
+        }
 
-            // Desenhar efeitos visuais para power-ups ativos
-            renderActivePowerUpEffects();
+        for (auto& shard : shards) {
+            shard->drainOutbox(outgoing);
+        }
+        for (auto& packet : outgoing) {
+            auto client = clients.find(packet.client);
+            if (client != clients.end()) {
+                client->second.send(move(packet.packet));
+            }
+        }
+        outgoing.clear();
+        vector<int> stalled;
+        for (auto& entry : clients) {
+            if (!entry.second.flush()) {
+                stalled.push_back(entry.first);
+            }
+        }
+        for (int client : stalled) {
+            dropClient(client);
+        }
 
-            if (specialEvent || !messageText.getString().isEmpty()) {
-                window.draw(messageText);
+        if (reportClock.getElapsedTime().asSeconds() >= SERVER_REPORT_SECONDS) {
+            reportClock.restart();
+            int sessions = 0;
+            for (auto& shard : shards) {
+                sessions += shard->sessionCount;
             }
-            
-            if (inBossFight) {
-                renderLifeBars();
+            cout << "Clientes: " << clients.size() << " | Sessoes: " << sessions << endl;
+        }
+    }
+
+    // Shards primeiro: depois deles nenhum pacote novo entra nas filas
+    cout << "Encerrando servidor..." << endl;
+    for (auto& shard : shards) {
+        shard->stop();
+    }
+    for (auto& entry : clients) {
+        entry.second.flush();
+        entry.second.socket->disconnect();
+    }
+    listener.close();
+    cout << "Servidor encerrado: " << sessionClient.size() << " sessoes fechadas" << endl;
+    return 0;
+}
+
+// --- Gerador de carga ---
+// Abre muitas sessões no servidor, divididas em algumas conexões (uma
+// thread cada), e toca em pontos aleatórios como o jogador --player random.
+// Mede o tempo entre mandar um toque e receber o estado que o confirma, e
+// pede ao servidor o tempo de CPU gasto nos ticks para estimar quantas
+// sessões cabem em cada núcleo.
+struct LoadConfig {
+    unsigned short port = SERVER_PORT;
+    int sessions = 200;
+    int connections = 4;
+    float seconds = 10.0f;
+    float tapRate = 2.0f; // Toques por segundo em cada sessão
+};
+
+class LoadClient {
+public:
+    vector<Int64> latencies; // µs, só durante a medição
+    long statePackets = 0;
+    long stateBytes = 0;
+    long restarts = 0;       // Partidas que acabaram e foram reabertas
+
+    LoadClient(const LoadConfig& c, int first, int count) : config(c), firstTag(first), slots(count) {}
+
+    void run(const atomic<bool>& measuring, const atomic<bool>& stopping) {
+        TcpSocket socket;
+        if (socket.connect(IpAddress::LocalHost, config.port) != Socket::Done) {
+            cerr << "Erro ao conectar ao servidor na porta " << config.port << endl;
+            return;
+        }
+        mt19937 rng(firstTag + 1);
+        uniform_real_distribution<float> unit(0.0f, 1.0f);
+        for (size_t i = 0; i < slots.size(); ++i) {
+            join(socket, i, rng());
+        }
+        socket.setBlocking(false);
+
+        Clock clock;
+        Int64 tapPeriod = static_cast<Int64>(1000000 / config.tapRate);
+        for (auto& slot : slots) {
+            slot.nextTap = static_cast<Int64>(unit(rng) * tapPeriod);
+        }
+
+        while (!stopping) {
+            Int64 now = clock.getElapsedTime().asMicroseconds();
+            for (size_t i = 0; i < slots.size(); ++i) {
+                Slot& slot = slots[i];
+                if (slot.session == 0 || now < slot.nextTap) continue;
+                slot.nextTap = now + static_cast<Int64>((0.5f + unit(rng)) * tapPeriod);
+                Vector2f position(unit(rng) * MOBILE_RESOLUTION_X, unit(rng) * MOBILE_RESOLUTION_Y);
+                send(socket, slot, ReplayInput::DOWN, position, now);
+                send(socket, slot, ReplayInput::UP, position, now);
+            }
+
+            Packet packet;
+            Socket::Status status;
+            while ((status = socket.receive(packet)) == Socket::Done) {
+                receive(socket, packet, clock.getElapsedTime().asMicroseconds(), measuring, rng);
+            }
+            if (status == Socket::Disconnected || status == Socket::Error) {
+                cerr << "Servidor desconectou" << endl;
+                return;
+            }
+            if (!flush(socket)) {
+                cerr << "Servidor desconectou" << endl;
+                return;
+            }
+            sleep(milliseconds(1));
+        }
+    }
+
+private:
+    struct Slot {
+        Uint32 session = 0;
+        Uint32 seq = 0;
+        Int64 nextTap = 0;
+        deque<pair<Uint32, Int64>> pending; // Sequência -> instante do envio
+        int phase = 0;
+    };
+
+    const LoadConfig& config;
+    int firstTag;
+    vector<Slot> slots;
+    deque<Packet> outbox; // Pacotes que o socket ainda não aceitou por inteiro
+
+    // Enfileira e manda o que der; o resto sai no próximo flush
+    void queue(TcpSocket& socket, Packet packet) {
+        outbox.push_back(move(packet));
+        flush(socket);
+    }
+
+    bool flush(TcpSocket& socket) {
+        while (!outbox.empty()) {
+            // Envio parcial: o mesmo pacote continua de onde parou
+            Socket::Status status = socket.send(outbox.front());
+            if (status == Socket::Partial || status == Socket::NotReady) return true;
+            if (status != Socket::Done) return false;
+            outbox.pop_front();
+        }
+        return true;
+    }
+
+    void join(TcpSocket& socket, size_t index, unsigned seed) {
+        Packet packet;
+        packet << static_cast<Uint8>(NET_JOIN) << static_cast<Uint32>(index) << static_cast<Uint32>(seed);
+        queue(socket, move(packet));
+        slots[index] = Slot();
+    }
+
+    void send(TcpSocket& socket, Slot& slot, ReplayInput::Type type, Vector2f position, Int64 now) {
+        Packet packet;
+        slot.seq++;
+        packet << static_cast<Uint8>(NET_INPUT) << slot.session << slot.seq << static_cast<Uint8>(type)
+               << position.x << position.y;
+        queue(socket, move(packet));
+        slot.pending.push_back(make_pair(slot.seq, now));
+    }
+
+    Slot* findSlot(Uint32 session) {
+        for (auto& slot : slots) {
+            if (slot.session == session) return &slot;
+        }
+        return nullptr;
+    }
+
+    void receive(TcpSocket& socket, Packet& packet, Int64 now, const atomic<bool>& measuring, mt19937& rng) {
+        Uint8 type = 0;
+        packet >> type;
+        if (type == NET_JOINED) {
+            Uint32 tag = 0, session = 0;
+            packet >> tag >> session;
+            if (tag < slots.size()) {
+                slots[tag].session = session;
+            }
+            return;
+        }
+        if (type != NET_STATE) return;
+
+        statePackets++;
+        stateBytes += static_cast<long>(packet.getDataSize());
+        Uint32 session = 0, tick = 0, ack = 0;
+        Uint8 mask = 0;
+        packet >> session >> tick >> ack >> mask;
+        Slot* slot = findSlot(session);
+        if (slot == nullptr) return;
+        while (!slot->pending.empty() && slot->pending.front().first <= ack) {
+            if (measuring) {
+                latencies.push_back(now - slot->pending.front().second);
             }
+            slot->pending.pop_front();
+        }
+
+        // Só os campos até as flags interessam aqui
+        Int32 score;
+        Int16 reputation, playerLife, bossLife;
+        Uint16 combo;
+        Uint8 phase = 0, flags = 0;
+        if (mask & STATE_SCORE) packet >> score;
+        if (mask & STATE_REPUTATION) packet >> reputation;
+        if (mask & STATE_COMBO) packet >> combo;
+        if (mask & STATE_PHASE) {
+            packet >> phase;
+            slot->phase = phase;
+        }
+        if (mask & STATE_LIVES) packet >> playerLife >> bossLife;
+        if (!(mask & STATE_FLAGS)) return;
+        packet >> flags;
+
+        // Fim de partida: fecha e abre outra, para manter a carga constante
+        bool bossWon = (flags & FLAG_PHASE_COMPLETE) && (flags & FLAG_BOSS_FIGHT);
+        if ((flags & FLAG_DEFEATED) || bossWon) {
+            Packet leave;
+            leave << static_cast<Uint8>(NET_LEAVE) << session;
+            queue(socket, move(leave));
+            restarts++;
+            join(socket, slot - slots.data(), rng());
+            return;
+        }
+        // Confirma as telas de transição e de introdução do boss na hora
+        if (flags & FLAG_PHASE_COMPLETE) {
+            send(socket, *slot, ReplayInput::ADVANCE_PHASE, Vector2f(), now);
+        } else if (slot->phase == BOSS && !(flags & FLAG_BOSS_FIGHT)) {
+            send(socket, *slot, ReplayInput::START_BOSS, Vector2f(), now);
+        }
+    }
+};
+
+void printLoadUsage() {
+    cout << "Uso: main.exe --load-test [opcoes]\n"
+            "  --port N             porta do servidor (53000)\n"
+            "  --sessions N         sessoes simultaneas (200)\n"
+            "  --connections N      conexoes TCP, uma thread cada (4)\n"
+            "  --seconds S          duracao da medicao (10)\n"
+            "  --taps N             toques por segundo em cada sessao (2)\n";
+}
+
+bool requestStats(TcpSocket& socket, bool reset, Packet& reply) {
+    Packet packet;
+    packet << static_cast<Uint8>(NET_STATS) << static_cast<Uint8>(reset ? 1 : 0);
+    if (socket.send(packet) != Socket::Done || socket.receive(reply) != Socket::Done) {
+        return false;
+    }
+    Uint8 type = 0;
+    reply >> type;
+    return type == NET_STATS_REPLY;
+}
+
+int runLoadTest(int argc, char* argv[]) {
+    LoadConfig config;
+    for (int i = 2; i < argc; i++) {
+        string arg = argv[i];
+        if (i + 1 >= argc) {
+            cerr << "Falta valor para " << arg << endl;
+            printLoadUsage();
+            return 1;
+        }
+        string value = argv[++i];
+        bool valid = true;
+        if (arg == "--port") valid = parseNumber(value, config.port);
+        else if (arg == "--sessions") valid = parseNumber(value, config.sessions);
+        else if (arg == "--connections") valid = parseNumber(value, config.connections);
+        else if (arg == "--seconds") valid = parseNumber(value, config.seconds);
+        else if (arg == "--taps") valid = parseNumber(value, config.tapRate);
+        else {
+            cerr << "Opcao desconhecida: " << arg << endl;
+            printLoadUsage();
+            return 1;
+        }
+        if (!valid) {
+            cerr << "Valor invalido para " << arg << ": " << value << endl;
+            printLoadUsage();
+            return 1;
+        }
+    }
+    config.sessions = max(1, config.sessions);
+    config.connections = min(max(1, config.connections), config.sessions);
+    config.tapRate = max(0.1f, config.tapRate);
+
+    TcpSocket control;
+    if (control.connect(IpAddress::LocalHost, config.port) != Socket::Done) {
+        cerr << "Erro ao conectar ao servidor na porta " << config.port << endl;
+        return 1;
+    }
+
+    vector<unique_ptr<LoadClient>> clients;
+    vector<thread> workers;
+    atomic<bool> measuring{false}, stopping{false};
+    for (int i = 0; i < config.connections; ++i) {
+        int first = config.sessions * i / config.connections;
+        int count = config.sessions * (i + 1) / config.connections - first;
+        clients.emplace_back(new LoadClient(config, first, count));
+        LoadClient* client = clients.back().get();
+        workers.emplace_back([client, &measuring, &stopping] { client->run(measuring, stopping); });
+    }
+
+    // Um segundo para as sessões abrirem, depois zera as estatísticas e mede
+    sleep(seconds(1.0f));
+    Packet reply;
+    if (!requestStats(control, true, reply)) {
+        cerr << "Erro ao pedir estatisticas ao servidor" << endl;
+    }
+    measuring = true;
+    sleep(seconds(config.seconds));
+    measuring = false;
+    bool gotStats = requestStats(control, false, reply);
+    stopping = true;
+    for (auto& worker : workers) {
+        worker.join();
+    }
 
-            window.display();
+    vector<Int64> latencies;
+    long packets = 0, bytes = 0, restarts = 0;
+    for (auto& client : clients) {
+        latencies.insert(latencies.end(), client->latencies.begin(), client->latencies.end());
+        packets += client->statePackets;
+        bytes += client->stateBytes;
+        restarts += client->restarts;
+    }
+    sort(latencies.begin(), latencies.end());
+
+    cout << fixed << setprecision(2);
+    cout << "Sessoes: " << config.sessions << " em " << config.connections << " conexoes | "
+         << config.seconds << "s medidos | partidas reabertas: " << restarts << endl;
+    cout << "Estado recebido: " << packets << " pacotes, "
+         << bytes / max(1.0f, config.seconds + 1.0f) / config.sessions << " bytes/s por sessao" << endl;
+    cout << "Toque -> estado (ms): p50 " << percentile(latencies, 0.5f) / 1000.0f
+         << " | p95 " << percentile(latencies, 0.95f) / 1000.0f
+         << " | p99 " << percentile(latencies, 0.99f) / 1000.0f
+         << " | max " << (latencies.empty() ? 0 : latencies.back()) / 1000.0f << endl;
+    if (gotStats) {
+        Uint32 sessions = 0, shards = 0;
+        Int64 elapsed = 0, busy = 0, p50 = 0, p95 = 0, p99 = 0, worst = 0;
+        Uint64 sessionTicks = 0;
+        reply >> sessions >> shards >> elapsed >> busy >> sessionTicks >> p50 >> p95 >> p99 >> worst;
+        float cores = static_cast<float>(busy) / max<Int64>(1, elapsed);
+        cout << "Servidor: " << sessions << " sessoes em " << shards << " shards | "
+             << cores << " nucleos ocupados | "
+             << (cores > 0 ? sessions / cores : 0.0f) << " sessoes por nucleo | "
+             << static_cast<float>(busy) / max<Uint64>(1, sessionTicks) << " us por tick de sessao" << endl;
+        cout << "Tick do shard (ms): p50 " << p50 / 1000.0f << " | p95 " << p95 / 1000.0f
+             << " | p99 " << p99 / 1000.0f << " | max " << worst / 1000.0f << endl;
+    }
+    return 0;
+}
+
+// --- Benchmark de rollback ---
+// Os dois lados do versus no mesmo processo, ligados por uma rede simulada
+// com atraso fixo e jogados por bots. Mede quanto custa ressimular e
+// confere que os dois lados e uma execução direta com as mesmas entradas
+// terminam no mesmo estado: main.exe --rollback-bench [ticks] [atraso]
+#define ROLLBACK_BENCH_SEED 12345
+
+// Toca no resíduo mais baixo e depois numa lixeira, como o SimPlayer,
+// mas devolvendo os toques em vez de aplicá-los
+class VersusBot {
+public:
+    mt19937 rng;
+    int cooldown = 0; // Ticks até o próximo toque
+    float accuracy = 0.9f;
+
+    explicit VersusBot(unsigned seed) : rng(seed) {}
+
+    TickInput act(const Simulation& board) {
+        TickInput input;
+        if (--cooldown > 0 || board.defeated) return input;
+        cooldown = uniform_int_distribution<int>(15, 45)(rng);
+
+        Vector2f target;
+        if (board.selectedWasteIndex == -1) {
+            if (board.activeWastes.empty()) return input;
+            size_t lowest = 0;
+            for (size_t i = 1; i < board.activeWastes.size(); ++i) {
+                if (board.activeWastes[i].position.y > board.activeWastes[lowest].position.y) {
+                    lowest = i;
+                }
+            }
+            target = SimPlayer::center(board.wasteBounds(board.activeWastes[lowest]));
+        } else {
+            WasteType bin = board.activeWastes[board.selectedWasteIndex].type;
+            if (uniform_real_distribution<float>(0.0f, 1.0f)(rng) >= accuracy) {
+                bin = board.binTypes[uniform_int_distribution<size_t>(0, board.binTypes.size() - 1)(rng)];
+            }
+            target = SimPlayer::center(board.binBounds.at(bin));
         }
+        input.add(ReplayInput::DOWN, target);
+        input.add(ReplayInput::UP, target);
+        return input;
     }
 };
 
-int main() {
-    Game game;
+int runRollbackBench(int argc, char* argv[]) {
+    Uint32 ticks = argc > 2 ? static_cast<Uint32>(max(1, atoi(argv[2]))) : 3600;
+    int lag = argc > 3 ? max(0, atoi(argv[3])) : 8; // Ticks que um pacote leva de um lado ao outro
+    SpriteMetrics metrics = SpriteMetrics::loadFromImages();
+
+    vector<RollbackSession> peers(2);
+    vector<VersusBot> bots = {VersusBot(ROLLBACK_BENCH_SEED + 1), VersusBot(ROLLBACK_BENCH_SEED + 2)};
+    vector<TickInput> played[2]; // Entrada de cada jogador por tick, para a execução direta
+    for (int p = 0; p < 2; ++p) {
+        peers[p].start(p, ROLLBACK_BENCH_SEED, metrics);
+        played[p].resize(ticks + VERSUS_INPUT_DELAY);
+    }
+
+    struct InFlight {
+        int arrival; // Frame em que chega
+        int to;
+        Uint32 tick;
+        TickInput input;
+    };
+    deque<InFlight> network; // Atraso fixo: a ordem de chegada é a de envio
+
+    Clock clock;
+    int stalls = 0;
+    for (int frame = 0; peers[0].match.tick < ticks || peers[1].match.tick < ticks; ++frame) {
+        while (!network.empty() && network.front().arrival <= frame) {
+            peers[network.front().to].addRemoteInput(network.front().tick, network.front().input);
+            network.pop_front();
+        }
+        for (int p = 0; p < 2; ++p) {
+            RollbackSession& peer = peers[p];
+            peer.rollback();
+            if (peer.match.tick >= ticks) continue;
+            if (!peer.canAdvance()) {
+                stalls++;
+                continue;
+            }
+            Uint32 tick = peer.localNext();
+            TickInput input = bots[p].act(peer.match.boards[p]);
+            played[p][tick] = input;
+            network.push_back(InFlight{frame + lag, 1 - p, tick, input});
+            peer.advance(input);
+        }
+    }
+    // O que ainda estava na rede corrige os últimos ticks previstos
+    for (const auto& packet : network) {
+        peers[packet.to].addRemoteInput(packet.tick, packet.input);
+    }
+    for (auto& peer : peers) {
+        peer.rollback();
+    }
+    Int64 rollbackMicros = clock.getElapsedTime().asMicroseconds();
+
+    VersusMatch direct;
+    direct.start(ROLLBACK_BENCH_SEED, metrics);
+    clock.restart();
+    for (Uint32 tick = 0; tick < ticks; ++tick) {
+        TickInput inputs[2] = {played[0][tick], played[1][tick]};
+        direct.step(inputs);
+    }
+    Int64 directMicros = clock.getElapsedTime().asMicroseconds();
+
+    long rollbacks = 0, resimulated = 0;
+    Int64 resimulateMicros = 0;
+    Uint32 maxDepth = 0;
+    for (const auto& peer : peers) {
+        rollbacks += peer.rollbacks;
+        resimulated += peer.resimulatedTicks;
+        resimulateMicros += peer.resimulateMicros;
+        maxDepth = max(maxDepth, peer.maxDepth);
+    }
+
+    cout << "Versus: " << ticks << " ticks | atraso da rede: " << lag << " ticks | atraso local: "
+         << VERSUS_INPUT_DELAY << " | janela: " << ROLLBACK_WINDOW << endl;
+    cout << "Direto: " << static_cast<float>(directMicros) / ticks << " us por tick (dois tabuleiros)" << endl;
+    cout << "Com rollback: " << static_cast<float>(rollbackMicros) / (2 * ticks) << " us por tick de cada lado, "
+         << stalls << " esperas pelo adversario" << endl;
+    cout << "Rollbacks: " << rollbacks << " | ticks ressimulados: " << resimulated << " | profundidade media: "
+         << static_cast<float>(resimulated) / max(1L, rollbacks) << ", maxima: " << maxDepth << endl;
+    cout << "Ressimulacao: " << resimulated / max(0.001f, resimulateMicros / 1000.0f) << " ticks por ms" << endl;
+    cout << "Snapshot: " << peers[0].match.snapshotBytes() << " bytes por tick, "
+         << ROLLBACK_WINDOW << " guardados por lado" << endl;
+
+    const VersusMatch& result = peers[0].match;
+    const char* outcome = result.winner < 0 ? "em andamento" : result.winner == 2 ? "empate" :
+                          result.winner == 0 ? "jogador 1 venceu" : "jogador 2 venceu";
+    cout << "Placar: " << result.boards[0].score << " x " << result.boards[1].score << " (" << outcome << ")" << endl;
+
+    // Os resumos que o VersusLink troca também precisam bater
+    for (int p = 0; p < 2; ++p) {
+        const RollbackSession& other = peers[1 - p];
+        peers[p].addRemoteChecksum(other.checkedTick, other.checksumAt(other.checkedTick));
+    }
+    bool same = peers[0].match.checksum() == direct.checksum() && peers[1].match.checksum() == direct.checksum() &&
+                !peers[0].desynced && !peers[1].desynced;
+    cout << "Determinismo: " << (same ? "OK" : "DIVERGIU") << endl;
+    return same ? 0 : 1;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && string(argv[1]) == "--batch") {
+        return runBatch(argc, argv);
+    }
+    if (argc > 1 && string(argv[1]) == "--render-bench") {
+        return runRenderBench(argc, argv);
+    }
+    if (argc > 1 && string(argv[1]) == "--export-replay") {
+        return runExportReplay(argc, argv);
+    }
+    if (argc > 1 && string(argv[1]) == "--server") {
+        return runServer(argc, argv);
+    }
+    if (argc > 1 && string(argv[1]) == "--load-test") {
+        return runLoadTest(argc, argv);
+    }
+    if (argc > 1 && string(argv[1]) == "--rollback-bench") {
+        return runRollbackBench(argc, argv);
+    }
+    if (argc > 1 && string(argv[1]) == "--build-catalog") {
+        if (argc < 4) {
+            cerr << "Uso: --build-catalog fonte.txt saida.cat" << endl;
+            return 1;
+        }
+        return Catalog::compile(argv[2], argv[3]) ? 0 : 1;
+    }
+
+    bool vsync = false;
+    bool frameStats = false;
+    bool latencyStats = false;
+    string rendererName = "sfml";
+    string recordFile;
+    string language = "pt";
+    size_t textureBudget = TEXTURE_BUDGET_MB;
+    int versusPort = 0;
+    string versusAddress;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--vsync") {
+            vsync = true;
+        } else if (arg == "--frame-stats") {
+            frameStats = true;
+        } else if (arg == "--input-latency") {
+            latencyStats = true;
+        } else if (arg == "--alloc-budget" && i + 1 < argc) {
+            AllocTracker::budget = atol(argv[++i]);
+        } else if (arg == "--renderer" && i + 1 < argc) {
+            rendererName = argv[++i];
+        } else if (arg == "--record" && i + 1 < argc) {
+            recordFile = argv[++i];
+        } else if (arg == "--versus-host" && i + 1 < argc) {
+            versusPort = atoi(argv[++i]);
+        } else if (arg == "--versus-join" && i + 1 < argc) {
+            versusAddress = argv[++i];
+        } else if (arg == "--lang" && i + 1 < argc) {
+            language = argv[++i];
+        } else if (arg == "--texture-budget" && i + 1 < argc) {
+            textureBudget = static_cast<size_t>(max(0, atoi(argv[++i])));
+        }
+    }
+
+    // A conexão vem antes da janela: a espera pelo adversário aparece no console
+    unique_ptr<VersusLink> versusLink;
+    if (versusPort > 0 || !versusAddress.empty()) {
+        versusLink = make_unique<VersusLink>();
+        bool connected = versusPort > 0 ? versusLink->host(static_cast<unsigned short>(versusPort))
+                                        : versusLink->join(versusAddress);
+        if (!connected) {
+            return 1;
+        }
+    }
+
+    Game game(vsync, frameStats, latencyStats, rendererName, recordFile, language, textureBudget);
+    if (versusLink) {
+        game.startVersus(move(versusLink));
+    }
     game.run();
     return 0;
-}
\ No newline at end of file
+}